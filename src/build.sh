@@ -0,0 +1,14 @@
+#!/bin/sh
+
+# @note linux build of the platform independent parts (headless simulation)
+
+cd "$(dirname "$0")"
+mkdir -p ../build
+
+# -O2 optimization level 2
+# -O0 -g for debbugging, no optimization
+# -DTETRIS_SLOW=1 checks the board caches against a full recompute after every change
+CommonCompilerFlags="-std=c++17 -O2 -g -Wno-write-strings -Wno-unused-result"
+
+c++ $CommonCompilerFlags -pthread -o ../build/tetris_headless linux_tetris_headless.cpp || exit 1
+c++ $CommonCompilerFlags -o ../build/tetris_bench linux_tetris_bench.cpp || exit 1
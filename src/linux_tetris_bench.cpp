@@ -0,0 +1,733 @@
+// @note Benchmarks for the simulation and render kernels, runs headless on linux.
+//       usage: tetris_bench [iteration_count] [--json path] [--baseline path] [--threshold percent]
+//       --json writes every result, --baseline compares against such a file and fails on regressions.
+
+
+// @note crt headers have to come before iml_types.h, it redefines inline
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <x86intrin.h>
+
+#include "tetris.cpp"
+#include "tetris_render.cpp"
+#include "tetris_placement.cpp"
+#include "tetris_frame.h"
+#include "tetris_input_queue.h"
+#include "tetris_snapshot.h"
+#include "tetris_replay.h"
+#include "tetris_rewind.h"
+#include "tetris_pathfinder.h"
+#include "tetris_planner.h"
+
+
+#define BENCH_BOARD_COUNT 256
+
+inline f64
+linux_get_seconds() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    f64 result = (f64)now.tv_sec + ((f64)now.tv_nsec / 1000000000.0);
+    return result;
+}
+
+// @note keeps the compiler from throwing away benchmark results
+global volatile u64 global_bench_sink;
+
+#define MAX_BENCH_RESULTS 64
+#define MAX_BENCH_NAME_LENGTH 64
+
+struct Bench_Result {
+    char name[MAX_BENCH_NAME_LENGTH];
+    char unit[16];   // @note what one op is, e.g. call, lock, pixel, frame
+    f64 cycles_per_op;
+    f64 ns_per_op;
+};
+
+global Bench_Result global_bench_results[MAX_BENCH_RESULTS];
+global int global_bench_result_count;
+
+internal void
+add_bench_result(const char *name, const char *unit, f64 cycles_per_op, f64 ns_per_op) {
+    assert(global_bench_result_count < MAX_BENCH_RESULTS);
+    Bench_Result *result = &global_bench_results[global_bench_result_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    snprintf(result->unit, sizeof(result->unit), "%s", unit);
+    result->cycles_per_op = cycles_per_op;
+    result->ns_per_op = ns_per_op;
+}
+
+struct Bench_Timing {
+    u64 cycles;
+    f64 seconds;
+};
+
+// @note best of three passes of op_count calls to body(i)
+template<typename Body>
+internal Bench_Timing
+time_best_of_three(u64 op_count, Body body) {
+    Bench_Timing best = {};
+    for (int pass = 0; pass < 3; ++pass) {
+        f64 start_seconds = linux_get_seconds();
+        u64 start = __rdtsc();
+        for (u64 i = 0; i < op_count; ++i) {
+            body(i);
+        }
+        u64 cycles = __rdtsc() - start;
+        f64 seconds = linux_get_seconds() - start_seconds;
+        if (pass == 0 || cycles < best.cycles) {
+            best.cycles = cycles;
+            best.seconds = seconds;
+        }
+    }
+    return best;
+}
+
+// @note prints and records one result, overhead is a timing of the same loop without the measured call
+internal void
+report_bench(const char *name, const char *unit, u64 op_count, Bench_Timing timing, Bench_Timing overhead = {}) {
+    u64 cycles = (timing.cycles > overhead.cycles) ? timing.cycles - overhead.cycles : 0;
+    f64 seconds = (timing.seconds > overhead.seconds) ? timing.seconds - overhead.seconds : 0;
+    f64 cycles_per_op = (f64)cycles / (f64)op_count;
+    f64 ns_per_op = (seconds * 1000000000.0) / (f64)op_count;
+    printf("%-28s %10.2f cycles/%-5s %10.2f ns/%s\n", name, cycles_per_op, unit, ns_per_op, unit);
+    add_bench_result(name, unit, cycles_per_op, ns_per_op);
+}
+
+// @note stack of random garbage with one hole per row, full_line_count full rows at the bottom of a 4 row window
+internal void
+make_line_clear_board(Game_State *game_state, Random_Series *series, int full_line_count) {
+    *game_state = {};
+    for (int y = 4; y < GRID_HEIGHT; ++y) {
+        int hole_x = (int)random_choice(series, GRID_WIDTH);
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            if (x == hole_x || random_choice(series, 4) == 0)  continue;
+            game_state->grid[y][x] = (int)(1 + random_choice(series, BAG_SIZE));
+            game_state->rows[y] |= (u16)(1 << x);
+        }
+    }
+    for (int i = 0; i < full_line_count; ++i) {
+        int y = GRID_HEIGHT - 1 - i;
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            if (!game_state->grid[y][x])  game_state->grid[y][x] = (int)(1 + random_choice(series, BAG_SIZE));
+        }
+        game_state->rows[y] = FULL_ROW_MASK;
+    }
+}
+
+// @note cost of one lock's line clear, the board copy is measured separately and subtracted
+internal void
+bench_line_clear(int full_line_count, u64 iteration_count) {
+    Random_Series series = random_seed(full_line_count + 1);
+    Game_State *boards = (Game_State *)malloc(BENCH_BOARD_COUNT * sizeof(Game_State));
+    for (int i = 0; i < BENCH_BOARD_COUNT; ++i) {
+        make_line_clear_board(&boards[i], &series, full_line_count);
+    }
+    Game_State work = {};
+    int top_y = GRID_HEIGHT - MAX_CLEARED_LINES;
+    int bottom_y = GRID_HEIGHT - 1;
+    
+    u64 copy_cycles = 0;
+    u64 compaction_cycles = 0;
+    u64 reference_cycles = 0;
+    f64 compaction_seconds = 0;
+    for (int pass = 0; pass < 3; ++pass) {
+        u64 start = __rdtsc();
+        for (u64 i = 0; i < iteration_count; ++i) {
+            Game_State *board = &boards[i & (BENCH_BOARD_COUNT - 1)];
+            memcpy(work.rows, board->rows, sizeof(work.rows));
+            memcpy(work.grid, board->grid, sizeof(work.grid));
+            global_bench_sink += work.rows[bottom_y];
+        }
+        u64 end = __rdtsc();
+        if (pass == 0 || (end - start) < copy_cycles)  copy_cycles = end - start;
+        
+        f64 start_seconds = linux_get_seconds();
+        start = __rdtsc();
+        for (u64 i = 0; i < iteration_count; ++i) {
+            Game_State *board = &boards[i & (BENCH_BOARD_COUNT - 1)];
+            memcpy(work.rows, board->rows, sizeof(work.rows));
+            memcpy(work.grid, board->grid, sizeof(work.grid));
+            global_bench_sink += clear_full_lines(&work, top_y, bottom_y).count;
+        }
+        end = __rdtsc();
+        f64 seconds = linux_get_seconds() - start_seconds;
+        if (pass == 0 || (end - start) < compaction_cycles) {
+            compaction_cycles = end - start;
+            compaction_seconds = seconds;
+        }
+        
+        start = __rdtsc();
+        for (u64 i = 0; i < iteration_count; ++i) {
+            Game_State *board = &boards[i & (BENCH_BOARD_COUNT - 1)];
+            memcpy(work.rows, board->rows, sizeof(work.rows));
+            memcpy(work.grid, board->grid, sizeof(work.grid));
+            global_bench_sink += clear_full_lines_reference(&work);
+        }
+        end = __rdtsc();
+        if (pass == 0 || (end - start) < reference_cycles)  reference_cycles = end - start;
+    }
+    free(boards);
+    
+    f64 compaction_per_lock = (f64)(compaction_cycles > copy_cycles ? compaction_cycles - copy_cycles : 0) / (f64)iteration_count;
+    f64 reference_per_lock  = (f64)(reference_cycles  > copy_cycles ? reference_cycles  - copy_cycles : 0) / (f64)iteration_count;
+    printf("line_clear %d lines:  %8.1f cycles/lock  (shift per line: %8.1f cycles/lock)  %6.1f ns/lock incl. copy\n",
+           full_line_count, compaction_per_lock, reference_per_lock,
+           (compaction_seconds * 1000000000.0) / (f64)iteration_count);
+    
+    char name[MAX_BENCH_NAME_LENGTH];
+    snprintf(name, sizeof(name), "line_clear_%d", full_line_count);
+    add_bench_result(name, "lock", compaction_per_lock, (compaction_seconds * 1000000000.0) / (f64)iteration_count);
+    snprintf(name, sizeof(name), "line_clear_reference_%d", full_line_count);
+    add_bench_result(name, "lock", reference_per_lock, 0);
+}
+
+// @note draws every grid cell, frame_count times, with the given blitter or the per pixel reference if blitter is null
+internal void
+bench_render_block(const char *name, Blit_Tile_Sig *blitter, u64 frame_count) {
+    u32 *pixels = (u32 *)malloc(WIDTH * HEIGHT * sizeof(u32));
+    Game_Offscreen_Buffer buffer = { pixels, WIDTH, HEIGHT, WIDTH * 4, 4 };
+    if (blitter)  blit_tile = blitter;
+    
+    u64 best_cycles = 0;
+    f64 best_seconds = 0;
+    for (int pass = 0; pass < 3; ++pass) {
+        f64 start_seconds = linux_get_seconds();
+        u64 start = __rdtsc();
+        for (u64 frame = 0; frame < frame_count; ++frame) {
+            for (int y = 0; y < GRID_HEIGHT; ++y) {
+                for (int x = 0; x < GRID_WIDTH; ++x) {
+                    enum32(Block_Type) type = 1 + ((x + y + (int)frame) % BAG_SIZE);
+                    if (blitter)  render_block(&buffer, Vector2{x,y}, type);
+                    else          render_block_reference(&buffer, Vector2{x,y}, type);
+                }
+            }
+            global_bench_sink += pixels[frame % (WIDTH * HEIGHT)];
+        }
+        u64 cycles = __rdtsc() - start;
+        f64 seconds = linux_get_seconds() - start_seconds;
+        if (pass == 0 || cycles < best_cycles) {
+            best_cycles = cycles;
+            best_seconds = seconds;
+        }
+    }
+    free(pixels);
+    init_renderer();
+    
+    f64 pixel_count = (f64)frame_count * GRID_WIDTH * GRID_HEIGHT * BLOCK_SIZE * BLOCK_SIZE;
+    printf("render_block %-9s %8.1f Mpixels/sec  %6.2f cycles/pixel\n",
+           name, (pixel_count / best_seconds) / 1000000.0, (f64)best_cycles / pixel_count);
+    
+    char result_name[MAX_BENCH_NAME_LENGTH];
+    snprintf(result_name, sizeof(result_name), "render_block_%s", name);
+    add_bench_result(result_name, "pixel", (f64)best_cycles / pixel_count, (best_seconds * 1000000000.0) / pixel_count);
+}
+
+// @note upscales the native backbuffer to the given scale, frame_count times
+internal void
+bench_upscale(const char *name, void (*upscaler)(Game_Offscreen_Buffer *, Game_Offscreen_Buffer *, int), int scale, u64 frame_count) {
+    u32 *native_pixels = (u32 *)malloc(WIDTH * HEIGHT * sizeof(u32));
+    u32 *scaled_pixels = (u32 *)malloc(WIDTH * HEIGHT * scale * scale * sizeof(u32));
+    Game_Offscreen_Buffer native = { native_pixels, WIDTH, HEIGHT, WIDTH * 4, 4 };
+    Game_Offscreen_Buffer scaled = { scaled_pixels, WIDTH * scale, HEIGHT * scale, WIDTH * scale * 4, 4 };
+    for (int i = 0; i < WIDTH * HEIGHT; ++i) {
+        native_pixels[i] = (u32)i * 2654435761u;
+    }
+    
+    u64 best_cycles = 0;
+    f64 best_seconds = 0;
+    for (int pass = 0; pass < 3; ++pass) {
+        f64 start_seconds = linux_get_seconds();
+        u64 start = __rdtsc();
+        for (u64 frame = 0; frame < frame_count; ++frame) {
+            upscaler(&scaled, &native, scale);
+            global_bench_sink += scaled_pixels[frame % (WIDTH * HEIGHT)];
+        }
+        u64 cycles = __rdtsc() - start;
+        f64 seconds = linux_get_seconds() - start_seconds;
+        if (pass == 0 || cycles < best_cycles) {
+            best_cycles = cycles;
+            best_seconds = seconds;
+        }
+    }
+    free(scaled_pixels);
+    free(native_pixels);
+    
+    f64 pixel_count = (f64)frame_count * WIDTH * HEIGHT * scale * scale;
+    printf("upscale x%-2d %-7s %8.1f Mpixels/sec  %6.2f cycles/pixel\n",
+           scale, name, (pixel_count / best_seconds) / 1000000.0, (f64)best_cycles / pixel_count);
+    
+    char result_name[MAX_BENCH_NAME_LENGTH];
+    snprintf(result_name, sizeof(result_name), "upscale_x%d_%s", scale, name);
+    add_bench_result(result_name, "pixel", (f64)best_cycles / pixel_count, (best_seconds * 1000000000.0) / pixel_count);
+}
+
+// @note random stacks and random in bounds pieces, shared by the collision and movement benchmarks
+struct Bench_Boards {
+    Game_State boards[BENCH_BOARD_COUNT];
+    Block blocks[BENCH_BOARD_COUNT];
+};
+
+internal Bench_Boards *
+make_bench_boards() {
+    Bench_Boards *result = (Bench_Boards *)malloc(sizeof(Bench_Boards));
+    Random_Series series = random_seed(42);
+    for (int i = 0; i < BENCH_BOARD_COUNT; ++i) {
+        Game_State *board = &result->boards[i];
+        init_game(board, i + 1);
+        int stack_height = (int)random_choice(&series, GRID_HEIGHT - 4);
+        for (int y = GRID_HEIGHT - stack_height; y < GRID_HEIGHT; ++y) {
+            int hole_x = (int)random_choice(&series, GRID_WIDTH);
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                if (x == hole_x || random_choice(&series, 3) == 0)  continue;
+                board->grid[y][x] = (int)(1 + random_choice(&series, BAG_SIZE));
+                board->rows[y] |= (u16)(1 << x);
+            }
+        }
+        
+        rebuild_board_cache(board);
+        
+        Block *block = &result->blocks[i];
+        *block = {};
+        block->type = 1 + random_choice(&series, BAG_SIZE);
+        u32 rotation = random_choice(&series, 4);
+        const Piece_Orientation *orientation = &piece_orientations[block->type][rotation];
+        int x = orientation->min_x * -1 + (int)random_choice(&series, GRID_WIDTH - (orientation->max_x - orientation->min_x));
+        int y = orientation->min_y * -1 + (int)random_choice(&series, GRID_HEIGHT - (orientation->max_y - orientation->min_y));
+        set_block_placement(block, x, y, rotation);
+        board->current_block = *block;
+    }
+    return result;
+}
+
+internal void
+bench_collision(Bench_Boards *bench_boards, u64 iteration_count) {
+    u64 mask = BENCH_BOARD_COUNT - 1;
+    Bench_Timing overhead = time_best_of_three(iteration_count, [&](u64 i) {
+        global_bench_sink += (u64)(uintptr)&bench_boards->blocks[(i * 7) & mask];
+    });
+    Bench_Timing timing = time_best_of_three(iteration_count, [&](u64 i) {
+        global_bench_sink += is_block_colliding(&bench_boards->boards[i & mask], &bench_boards->blocks[(i * 7) & mask]);
+    });
+    report_bench("is_block_colliding", "call", iteration_count, timing, overhead);
+    timing = time_best_of_three(iteration_count, [&](u64 i) {
+        global_bench_sink += is_block_colliding_reference(&bench_boards->boards[i & mask], &bench_boards->blocks[(i * 7) & mask]);
+    });
+    report_bench("is_block_colliding_reference", "call", iteration_count, timing, overhead);
+    
+    // @note shifted so about half of the blocks stick out
+    Block shifted[BENCH_BOARD_COUNT];
+    for (int i = 0; i < BENCH_BOARD_COUNT; ++i) {
+        shifted[i] = bench_boards->blocks[i];
+        int dx = (i & 1) ? ((i & 2) ? -3 : 3) : 0;
+        set_block_placement(&shifted[i], shifted[i].origin.x + dx, shifted[i].origin.y, shifted[i].rotation);
+    }
+    timing = time_best_of_three(iteration_count, [&](u64 i) {
+        global_bench_sink += is_block_out_of_bounds(&shifted[i & mask]);
+    });
+    report_bench("is_block_out_of_bounds", "call", iteration_count, timing, overhead);
+    timing = time_best_of_three(iteration_count, [&](u64 i) {
+        global_bench_sink += is_block_out_of_bounds_reference(&shifted[i & mask]);
+    });
+    report_bench("is_block_out_of_bounds_reference", "call", iteration_count, timing, overhead);
+}
+
+// @note the current_block is restored before every call, the restore is measured separately and subtracted
+internal void
+bench_movement(Bench_Boards *bench_boards, u64 iteration_count) {
+    u64 mask = BENCH_BOARD_COUNT - 1;
+    Bench_Timing overhead = time_best_of_three(iteration_count, [&](u64 i) {
+        Game_State *board = &bench_boards->boards[i & mask];
+        board->current_block = bench_boards->blocks[i & mask];
+        global_bench_sink += board->current_block.origin.x;
+    });
+    Bench_Timing timing = time_best_of_three(iteration_count, [&](u64 i) {
+        Game_State *board = &bench_boards->boards[i & mask];
+        board->current_block = bench_boards->blocks[i & mask];
+        global_bench_sink += rotate_block(board, &board->current_block, (i & 1) != 0);
+    });
+    report_bench("rotate_block", "call", iteration_count, timing, overhead);
+    timing = time_best_of_three(iteration_count, [&](u64 i) {
+        Game_State *board = &bench_boards->boards[i & mask];
+        board->current_block = bench_boards->blocks[i & mask];
+        move_current_block_left(board);
+        global_bench_sink += board->current_block.origin.x;
+    });
+    report_bench("move_current_block_left", "call", iteration_count, timing, overhead);
+    timing = time_best_of_three(iteration_count, [&](u64 i) {
+        Game_State *board = &bench_boards->boards[i & mask];
+        board->current_block = bench_boards->blocks[i & mask];
+        move_current_block_right(board);
+        global_bench_sink += board->current_block.origin.x;
+    });
+    report_bench("move_current_block_right", "call", iteration_count, timing, overhead);
+}
+
+// @note a hard drop from the spawn row, the column lookup against stepping down one row at a time
+internal void
+bench_drop_distance(Bench_Boards *bench_boards, u64 iteration_count) {
+    u64 mask = BENCH_BOARD_COUNT - 1;
+    Bench_Timing timing = time_best_of_three(iteration_count, [&](u64 i) {
+        Block block = get_spawn_block(bench_boards->blocks[i & mask].type);
+        global_bench_sink += get_drop_distance(&bench_boards->boards[i & mask], block.type, 0, block.origin.x, block.origin.y);
+    });
+    report_bench("get_drop_distance", "call", iteration_count, timing);
+    timing = time_best_of_three(iteration_count, [&](u64 i) {
+        Block block = get_spawn_block(bench_boards->blocks[i & mask].type);
+        global_bench_sink += get_drop_distance_reference(&bench_boards->boards[i & mask], &block);
+    });
+    report_bench("get_drop_distance_reference", "call", iteration_count, timing);
+}
+
+// @note updating the features for one locked piece against recomputing them from the landing board, the copy is overhead
+internal void
+bench_board_features(Bench_Boards *bench_boards, u64 iteration_count) {
+    u64 mask = BENCH_BOARD_COUNT - 1;
+    u16 rows[GRID_HEIGHT];
+    int column_tops[GRID_WIDTH];
+    Board_Features features;
+    Bench_Timing overhead = time_best_of_three(iteration_count, [&](u64 i) {
+        Game_State *board = &bench_boards->boards[i & mask];
+        memcpy(rows, board->rows, sizeof(rows));
+        memcpy(column_tops, board->column_tops, sizeof(column_tops));
+        features = board->features;
+        global_bench_sink += rows[GRID_HEIGHT - 1] + column_tops[0] + features.holes;
+    });
+    Bench_Timing timing = time_best_of_three(iteration_count, [&](u64 i) {
+        Game_State *board = &bench_boards->boards[i & mask];
+        Block block = get_spawn_block(bench_boards->blocks[i & mask].type);
+        memcpy(rows, board->rows, sizeof(rows));
+        memcpy(column_tops, board->column_tops, sizeof(column_tops));
+        features = board->features;
+        int y = block.origin.y + get_drop_distance(board, block.type, 0, block.origin.x, block.origin.y);
+        add_piece_to_board(rows, column_tops, &features, block.type, 0, block.origin.x, y);
+        global_bench_sink += features.holes;
+    });
+    report_bench("add_piece_to_board", "call", iteration_count, timing, overhead);
+    timing = time_best_of_three(iteration_count, [&](u64 i) {
+        Game_State *board = &bench_boards->boards[i & mask];
+        memcpy(rows, board->rows, sizeof(rows));
+        memcpy(column_tops, board->column_tops, sizeof(column_tops));
+        features = get_board_features(rows, column_tops);
+        global_bench_sink += rows[GRID_HEIGHT - 1] + column_tops[0] + features.holes;
+    });
+    report_bench("get_board_features", "call", iteration_count, timing, overhead);
+}
+
+// @note The bench boards' blocks can overlap their stacks, the snapshots spawn a piece instead so every load
+//       succeeds. Loading rebuilds the occupancy and the board caches from the packed color plane.
+internal void
+bench_snapshots(Bench_Boards *bench_boards, u64 iteration_count) {
+    u64 mask = BENCH_BOARD_COUNT - 1;
+    local_persist Snapshot snapshots[BENCH_BOARD_COUNT];
+    local_persist Game_State game_state;
+    Bench_Timing timing = time_best_of_three(iteration_count, [&](u64 i) {
+        save_snapshot(&bench_boards->boards[i & mask], &snapshots[i & mask]);
+        global_bench_sink += snapshots[i & mask].packed_rows[GRID_HEIGHT - 1];
+    });
+    report_bench("save_snapshot", "call", iteration_count, timing);
+    for (int i = 0; i < BENCH_BOARD_COUNT; ++i) {
+        Block spawn = get_spawn_block(bench_boards->blocks[i].type);
+        snapshots[i].current_block = pack_snapshot_block(&spawn);
+    }
+    timing = time_best_of_three(iteration_count, [&](u64 i) {
+        global_bench_sink += load_snapshot(&snapshots[i & mask], &game_state);
+        global_bench_sink += game_state.features.holes;
+    });
+    report_bench("load_snapshot", "call", iteration_count, timing);
+}
+
+internal void
+bench_placements(Bench_Boards *bench_boards, u64 iteration_count) {
+    u64 mask = BENCH_BOARD_COUNT - 1;
+    local_persist Placement_List placements;
+    Bench_Timing timing = time_best_of_three(iteration_count, [&](u64 i) {
+        global_bench_sink += enumerate_placements(&bench_boards->boards[i & mask], bench_boards->blocks[i & mask].type, &placements);
+    });
+    report_bench("enumerate_placements", "call", iteration_count, timing);
+}
+
+// @note the uncached search, find_reachable_spots only pays it once per board and piece
+internal void
+bench_pathfinder(Bench_Boards *bench_boards, u64 iteration_count) {
+    u64 mask = BENCH_BOARD_COUNT - 1;
+    Pathfinder *pathfinder = (Pathfinder *)malloc(sizeof(Pathfinder));
+    init_pathfinder(pathfinder);
+    local_persist Reachable_Set set;
+    Bench_Timing timing = time_best_of_three(iteration_count, [&](u64 i) {
+        Game_State *board = &bench_boards->boards[i & mask];
+        Block start = get_spawn_block(bench_boards->blocks[i & mask].type);
+        memcpy(pathfinder->scratch_state.rows, board->rows, sizeof(board->rows));
+        search_reachable_spots(pathfinder, &start, &set);
+        global_bench_sink += set.count;
+    });
+    free(pathfinder);
+    report_bench("search_reachable_spots", "call", iteration_count, timing);
+}
+
+// @note Rewinds to random steps of a recorded game, a keyframe load plus half a chunk of steps on average.
+//       Nothing is recorded in between, so putting step_count back brings the dropped steps back.
+internal void
+bench_rewind(u64 iteration_count) {
+    u64 memory_size = 64 * get_rewind_chunk_size(REWIND_KEYFRAME_INTERVAL);
+    void *memory = malloc((size_t)memory_size);
+    Rewind_Buffer rewind;
+    init_rewind_buffer(&rewind, memory, memory_size);
+    Game_State game_state;
+    init_game(&game_state, 3);
+    Random_Series series = random_seed(11);
+    for (u32 step = 0; step < 64 * REWIND_KEYFRAME_INTERVAL; ++step) {
+        Game_Controller_Input controller = {};
+        controller.is_connected = true;
+        u32 choice = random_choice(&series, 16);
+        if (choice < array_count(controller.buttons))  controller.buttons[choice].ended_down = true;
+        record_rewind_step(&rewind, &game_state, &controller, 1);
+        game_step(&game_state, &controller, 1);
+    }
+    u64 step_count = rewind.step_count;
+    Bench_Timing timing = time_best_of_three(iteration_count, [&](u64) {
+        rewind.step_count = step_count;
+        rewind_to_step(&rewind, random_choice(&series, (u32)step_count), &game_state);
+        global_bench_sink += game_state.tick_count;
+    });
+    free(memory);
+    report_bench("rewind_to_step", "call", iteration_count, timing);
+}
+
+// @note A tap pushed and taken at the next tick on one thread, the cost without contention. The queue stays
+//       almost empty like in a game, every take finds the producer's counter moved.
+internal void
+bench_input_queue(u64 iteration_count) {
+    Input_Queue *queue = (Input_Queue *)aligned_alloc(INPUT_QUEUE_CACHE_LINE_SIZE, sizeof(Input_Queue));
+    memset(queue, 0, sizeof(Input_Queue));
+    Input_Tracker tracker = {};
+    Game_Input tick_input;
+    Bench_Timing timing = time_best_of_three(iteration_count, [&](u64 i) {
+        Input_Event press = make_input_event((f64)i, 0, (u32)(i % 12), true);
+        Input_Event release = make_input_event((f64)i + 0.5, 0, (u32)(i % 12), false);
+        push_input_event(queue, &press);
+        push_input_event(queue, &release);
+        take_input_events(queue, &tracker, (f64)i + 1.0, &tick_input);
+        global_bench_sink += tick_input.controllers[0].buttons[i % 12].half_transition_count;
+    });
+    free(queue);
+    report_bench("input_queue_tap", "tap", iteration_count, timing);
+}
+
+// @note bot searches along a game it plays itself, no time budget so every search goes to the full depth
+internal void
+bench_planner(u32 depth, u32 beam_width, u64 plan_count) {
+    Planner *planner = (Planner *)aligned_alloc(64, sizeof(Planner));
+    init_planner(planner);
+    Planner_Settings settings = { depth, beam_width, 0 };
+    Game_State game_state;
+    init_game(&game_state, 5);
+    plan_placement(planner, &game_state, &settings, linux_get_seconds); // @note touch the memory once
+    Bench_Timing timing = time_best_of_three(plan_count, [&](u64) {
+        Planner_Result result = plan_placement(planner, &game_state, &settings, linux_get_seconds);
+        lock_placement(&game_state, &result.placement);
+        global_bench_sink += result.node_count;
+    });
+    free(planner);
+    
+    char name[MAX_BENCH_NAME_LENGTH];
+    snprintf(name, sizeof(name), "plan_depth%u_width%u", depth, beam_width);
+    report_bench(name, "plan", plan_count, timing);
+}
+
+internal void
+bench_clear_buffer(int scale, u64 frame_count) {
+    u32 *pixels = (u32 *)malloc(WIDTH * HEIGHT * scale * scale * sizeof(u32));
+    Game_Offscreen_Buffer buffer = { pixels, WIDTH * scale, HEIGHT * scale, WIDTH * scale * 4, 4 };
+    Bench_Timing timing = time_best_of_three(frame_count, [&](u64 i) {
+        clear_buffer(&buffer);
+        global_bench_sink += pixels[i % (WIDTH * HEIGHT)];
+    });
+    free(pixels);
+    
+    char name[MAX_BENCH_NAME_LENGTH];
+    snprintf(name, sizeof(name), "clear_buffer_x%d", scale);
+    report_bench(name, "frame", frame_count, timing);
+}
+
+// @note one frame like the platform layer does it, a tick with random input plus the incremental render
+internal void
+bench_simulated_frame(int scale, u64 frame_count) {
+    u32 *pixels = (u32 *)malloc(WIDTH * HEIGHT * scale * scale * sizeof(u32));
+    Game_Offscreen_Buffer buffer = { pixels, WIDTH * scale, HEIGHT * scale, WIDTH * scale * 4, 4 };
+    
+    Bench_Timing best = {};
+    for (int pass = 0; pass < 3; ++pass) {
+        // @note same game every pass
+        Game_State game_state;
+        init_game(&game_state, 1);
+        Render_State render_state = {};
+        Random_Series series = random_seed(7);
+        Bench_Timing timing = time_best_of_three(1, [&](u64) {
+            for (u64 frame = 0; frame < frame_count; ++frame) {
+                Game_Controller_Input controller = {};
+                controller.is_connected = true;
+                u32 choice = random_choice(&series, 16);
+                if (choice < array_count(controller.buttons))  controller.buttons[choice].ended_down = true;
+                game_step(&game_state, &controller, 1);
+                render_game(&render_state, &buffer, &game_state);
+            }
+        });
+        if (pass == 0 || timing.cycles < best.cycles)  best = timing;
+    }
+    free(pixels);
+    init_renderer();
+    
+    char name[MAX_BENCH_NAME_LENGTH];
+    snprintf(name, sizeof(name), "simulated_frame_x%d", scale);
+    report_bench(name, "frame", frame_count, best);
+}
+
+//
+// @note machine readable results and baseline comparison
+//
+
+// @note one result per line, so read_bench_baseline can get away with sscanf
+internal b32
+write_bench_json(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file)  return false;
+    fprintf(file, "{\n  \"results\": [\n");
+    for (int i = 0; i < global_bench_result_count; ++i) {
+        Bench_Result *result = &global_bench_results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"unit\": \"%s\", \"cycles_per_op\": %.4f, \"ns_per_op\": %.4f}%s\n",
+                result->name, result->unit, result->cycles_per_op, result->ns_per_op,
+                (i + 1 < global_bench_result_count) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    b32 result = (fclose(file) == 0);
+    return result;
+}
+
+internal int
+read_bench_baseline(const char *path, Bench_Result *results, int max_count) {
+    FILE *file = fopen(path, "rb");
+    if (!file)  return -1;
+    int count = 0;
+    char line[512];
+    while (count < max_count && fgets(line, sizeof(line), file)) {
+        Bench_Result *result = &results[count];
+        if (sscanf(line, " {\"name\": \"%63[^\"]\", \"unit\": \"%15[^\"]\", \"cycles_per_op\": %lf, \"ns_per_op\": %lf",
+                   result->name, result->unit, &result->cycles_per_op, &result->ns_per_op) == 4) {
+            ++count;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+// @note returns the number of results that got slower than threshold_percent in cycles/op
+internal int
+compare_bench_baseline(Bench_Result *baseline, int baseline_count, f64 threshold_percent) {
+    int regression_count = 0;
+    printf("\n%-32s %12s %12s %9s\n", "compared to baseline", "baseline", "current", "change");
+    for (int i = 0; i < global_bench_result_count; ++i) {
+        Bench_Result *result = &global_bench_results[i];
+        Bench_Result *base = 0;
+        for (int j = 0; j < baseline_count; ++j) {
+            if (strcmp(baseline[j].name, result->name) == 0)  base = &baseline[j];
+        }
+        if (!base || base->cycles_per_op <= 0.0) {
+            printf("%-32s %12s %12.2f\n", result->name, "-", result->cycles_per_op);
+            continue;
+        }
+        
+        f64 change_percent = ((result->cycles_per_op - base->cycles_per_op) / base->cycles_per_op) * 100.0;
+        b32 is_regression = (change_percent > threshold_percent);
+        if (is_regression)  ++regression_count;
+        printf("%-32s %12.2f %12.2f %+8.1f%%%s\n", result->name, base->cycles_per_op, result->cycles_per_op,
+               change_percent, is_regression ? "  REGRESSION" : "");
+    }
+    return regression_count;
+}
+
+int
+main(int argc, char **argv) {
+    u64 iteration_count = 1000000;
+    const char *json_path = 0;
+    const char *baseline_path = 0;
+    f64 threshold_percent = 10.0;
+    for (int arg_index = 1; arg_index < argc; ++arg_index) {
+        if (strcmp(argv[arg_index], "--json") == 0 && arg_index + 1 < argc)  json_path = argv[++arg_index];
+        else if (strcmp(argv[arg_index], "--baseline") == 0 && arg_index + 1 < argc)  baseline_path = argv[++arg_index];
+        else if (strcmp(argv[arg_index], "--threshold") == 0 && arg_index + 1 < argc)  threshold_percent = strtod(argv[++arg_index], 0);
+        else  iteration_count = strtoull(argv[arg_index], 0, 10);
+    }
+    if (iteration_count == 0) {
+        fprintf(stderr, "usage: %s [iteration_count] [--json path] [--baseline path] [--threshold percent]\n", argv[0]);
+        return 1;
+    }
+    
+    // @note read before running, a missing baseline should not cost a whole benchmark run
+    local_persist Bench_Result baseline[MAX_BENCH_RESULTS];
+    int baseline_count = 0;
+    if (baseline_path) {
+        baseline_count = read_bench_baseline(baseline_path, baseline, MAX_BENCH_RESULTS);
+        if (baseline_count < 0) {
+            fprintf(stderr, "could not read baseline %s\n", baseline_path);
+            return 1;
+        }
+    }
+    
+    Bench_Boards *bench_boards = make_bench_boards();
+    bench_collision(bench_boards, iteration_count);
+    bench_movement(bench_boards, iteration_count);
+    bench_drop_distance(bench_boards, iteration_count);
+    bench_board_features(bench_boards, iteration_count);
+    bench_snapshots(bench_boards, iteration_count);
+    bench_placements(bench_boards, iteration_count / 16);
+    bench_pathfinder(bench_boards, iteration_count / 256 + 1);
+    bench_rewind(iteration_count / 64 + 1);
+    bench_input_queue(iteration_count / 16 + 1);
+    free(bench_boards);
+    bench_planner(3, 32, iteration_count / 2000 + 1);
+    
+    bench_line_clear(0, iteration_count);
+    bench_line_clear(1, iteration_count);
+    bench_line_clear(2, iteration_count);
+    bench_line_clear(4, iteration_count);
+    
+    init_renderer();
+    u64 frame_count = iteration_count / 100;
+    if (frame_count == 0)  frame_count = 1;
+    bench_render_block("reference", 0, frame_count);
+    bench_render_block("scalar", blit_tile_scalar, frame_count);
+#if TETRIS_X86
+    Cpu_Features features = get_cpu_features();
+    if (features.sse2)  bench_render_block("sse2", blit_tile_sse2, frame_count);
+    if (features.avx2)  bench_render_block("avx2", blit_tile_avx2, frame_count);
+#endif
+    
+    u64 upscale_frame_count = (frame_count / 10) + 1;
+    int upscale_scales[] = { 2, 6 };
+    for (int scale_index = 0; scale_index < (int)array_count(upscale_scales); ++scale_index) {
+        bench_upscale("scalar", upscale_nearest_scalar, upscale_scales[scale_index], upscale_frame_count);
+#if TETRIS_X86
+        bench_upscale("sse2", upscale_nearest_sse2, upscale_scales[scale_index], upscale_frame_count);
+#endif
+    }
+    
+    bench_clear_buffer(1, frame_count);
+    bench_clear_buffer(6, upscale_frame_count);
+    bench_simulated_frame(1, frame_count);
+    bench_simulated_frame(6, frame_count);
+    
+    if (json_path && !write_bench_json(json_path)) {
+        fprintf(stderr, "could not write %s\n", json_path);
+        return 1;
+    }
+    if (baseline_path) {
+        int regression_count = compare_bench_baseline(baseline, baseline_count, threshold_percent);
+        if (regression_count > 0) {
+            printf("%d regressions over %.1f%%\n", regression_count, threshold_percent);
+            return 2;
+        }
+    }
+    return 0;
+}
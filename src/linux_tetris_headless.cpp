@@ -0,0 +1,1594 @@
+// @note Headless batch driver, runs the simulation unthrottled without a window.
+//       usage: tetris_headless [--20g] [game_count] [ticks_per_step] [seed]
+//              tetris_headless --verify [iteration_count]
+//              tetris_headless --paced|--paced-early [seconds] [frame_hz] [tick_hz] [log_path_prefix]
+//              tetris_headless [--20g] --record path [game_count] [ticks_per_step] [seed]
+//              tetris_headless --replay path [repeat_count]
+//              tetris_headless --snapshots path [count] [seed]
+//              tetris_headless --selfplay [game_count] [thread_count] [policy] [max_pieces] [first_seed]
+//              tetris_headless --bot [piece_count] [depth] [beam_width] [budget_ms] [seed]
+
+
+// @note crt headers have to come before iml_types.h, it redefines inline
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tetris.cpp"
+#include "tetris_render.cpp"
+#include "tetris_placement.cpp"
+#include "tetris_frame.h"
+#include "tetris_frame_log.h"
+#include "tetris_input_queue.h"
+#include "tetris_snapshot.h"
+#include "tetris_replay.h"
+#include "tetris_rewind.h"
+#include "tetris_selfplay.h"
+#include "tetris_pathfinder.h"
+#include "tetris_planner.h"
+
+
+inline f64
+linux_get_seconds() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    f64 result = (f64)now.tv_sec + ((f64)now.tv_nsec / 1000000000.0);
+    return result;
+}
+
+internal
+PLATFORM_SLEEP_SECONDS_SIG(linux_sleep_seconds) {
+    if (seconds <= 0)  return;
+    timespec duration;
+    duration.tv_sec = (time_t)seconds;
+    duration.tv_nsec = (long)((seconds - (f64)duration.tv_sec) * 1000000000.0);
+    clock_nanosleep(CLOCK_MONOTONIC, 0, &duration, 0);
+}
+
+// @note xorshift32, only used to generate synthetic button presses for the batch run
+internal u32
+next_input_random(u32 *state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+internal void
+make_random_input(Game_Controller_Input *controller, u32 *random_state) {
+    *controller = {};
+    controller->is_connected = true;
+    
+    // @note most ticks nothing is pressed, like a human player
+    u32 choice = next_input_random(random_state) % 16;
+    if      (choice == 0)  controller->move_left.ended_down = true;
+    else if (choice == 1)  controller->move_right.ended_down = true;
+    else if (choice == 2)  controller->move_down.ended_down = true;
+    else if (choice == 3)  controller->action_down.ended_down = true;
+    else if (choice == 4)  controller->action_right.ended_down = true;
+    else if (choice == 5 && (next_input_random(random_state) % 4) == 0)  controller->move_up.ended_down = true;
+}
+
+//
+// @note batch self-play
+//
+
+struct Linux_Selfplay_Thread {
+    Selfplay_Batch *batch;
+    u32 worker_index;
+};
+
+internal void *
+linux_selfplay_thread_proc(void *parameter) {
+    Linux_Selfplay_Thread *thread = (Linux_Selfplay_Thread *)parameter;
+    run_selfplay_worker(thread->batch, thread->worker_index);
+    return 0;
+}
+
+// @note worker 0 runs on the calling thread, returns the wall clock seconds for the whole batch
+internal f64
+run_selfplay_batch(Selfplay_Batch *batch) {
+    pthread_t threads[MAX_SELFPLAY_WORKERS];
+    Linux_Selfplay_Thread thread_parameters[MAX_SELFPLAY_WORKERS];
+    f64 start_seconds = linux_get_seconds();
+    u32 started_count = 1;
+    for (u32 worker_index = 1; worker_index < batch->worker_count; ++worker_index) {
+        thread_parameters[worker_index] = { batch, worker_index };
+        // @note if a thread can not be created its games get stolen by the others
+        if (pthread_create(&threads[worker_index], 0, linux_selfplay_thread_proc, &thread_parameters[worker_index]) != 0)  break;
+        ++started_count;
+    }
+    run_selfplay_worker(batch, 0);
+    for (u32 worker_index = 1; worker_index < started_count; ++worker_index) {
+        pthread_join(threads[worker_index], 0);
+    }
+    f64 result = linux_get_seconds() - start_seconds;
+    return result;
+}
+
+struct Selfplay_Policy_Entry {
+    const char *name;
+    Selfplay_Policy_Sig *policy;
+};
+
+global Selfplay_Policy_Entry global_selfplay_policies[] = {
+    { "random",    selfplay_policy_random },
+    { "heuristic", selfplay_policy_heuristic },
+};
+
+// @note big, every worker carries a game state and a placement list
+global Selfplay_Batch global_selfplay_batch;
+
+//
+// @note synthetic input
+//
+
+// @note the producer end of the input queue in verify, pushes event i with i as its time and retries when full
+struct Linux_Input_Producer {
+    Input_Queue *queue;
+    u64 event_count;
+    u64 full_count;
+};
+
+internal void *
+linux_input_producer_proc(void *parameter) {
+    Linux_Input_Producer *producer = (Linux_Input_Producer *)parameter;
+    for (u64 i = 0; i < producer->event_count;) {
+        Input_Event event = make_input_event((f64)i, (u32)(i % 5), (u32)(i % 12), (i / 12) % 2);
+        if (push_input_event(producer->queue, &event))  ++i;
+        else  ++producer->full_count;
+    }
+    return 0;
+}
+
+// @note Stands in for the platform's input thread in the paced run, taps random buttons of controller 0 at
+//       random times with the same odds as make_random_input, timestamped on the same clock as the frame loop.
+struct Linux_Input_Thread {
+    Input_Queue *queue;
+    volatile u64 is_running;
+    u32 random_state;
+};
+
+internal void *
+linux_input_thread_proc(void *parameter) {
+    Linux_Input_Thread *thread = (Linux_Input_Thread *)parameter;
+    while (atomic_load_acquire_u64(&thread->is_running)) {
+        linux_sleep_seconds(0.001 * (f64)(1 + next_input_random(&thread->random_state) % 8));
+        Game_Controller_Input controller;
+        make_random_input(&controller, &thread->random_state);
+        for (u32 button_index = 0; button_index < array_count(controller.buttons); ++button_index) {
+            if (!controller.buttons[button_index].ended_down)  continue;
+            Input_Event press = make_input_event(linux_get_seconds(), 0, button_index, true);
+            push_input_event(thread->queue, &press);
+            linux_sleep_seconds(0.001 * (f64)(1 + next_input_random(&thread->random_state) % 4));
+            Input_Event release = make_input_event(linux_get_seconds(), 0, button_index, false);
+            push_input_event(thread->queue, &release);
+        }
+    }
+    return 0;
+}
+
+//
+// @note verify
+//
+
+// @note one subsystem's checks, returns how many failed
+#define VERIFY_SIG(name) u64 name(u64 iteration_count)
+typedef VERIFY_SIG(Verify_Sig);
+
+#define MAX_REPORTED_VERIFY_FAILURES 32
+
+global u64 global_verify_failure_count; // @note over all subsystems, only the first ones get printed
+
+internal void
+report_verify_failure(const char *file, int line, const char *expression) {
+    ++global_verify_failure_count;
+    if (global_verify_failure_count <= MAX_REPORTED_VERIFY_FAILURES) {
+        fprintf(stderr, "%s:%d: verify failed: %s\n", file, line, expression);
+    }
+}
+
+// @note counts into the failure_count of the VERIFY_SIG function it is used in
+#define VERIFY_CHECK(expression) do { if (!(expression)) { ++failure_count; report_verify_failure(__FILE__, __LINE__, #expression); } } while (0)
+
+// @note Random stack with holes and overhangs, columns below max_height with one in skip_one_in of their cells
+//       left empty. A full row can not exist between two locks, so full rows get a hole punched into them.
+internal void
+make_random_board(Game_State *board, u32 *random_state, int max_height, u32 skip_one_in) {
+    *board = {};
+    for (int x = 0; x < GRID_WIDTH; ++x) {
+        int height = (int)(next_input_random(random_state) % max_height);
+        for (int y = GRID_HEIGHT - height; y < GRID_HEIGHT; ++y) {
+            if ((next_input_random(random_state) % skip_one_in) == 0)  continue;
+            board->grid[y][x] = (int)(1 + (next_input_random(random_state) % BAG_SIZE));
+            board->rows[y] |= (u16)(1 << x);
+        }
+    }
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        if (board->rows[y] != FULL_ROW_MASK)  continue;
+        int hole_x = (int)(next_input_random(random_state) % GRID_WIDTH);
+        board->grid[y][hole_x] = Block_Type::EMPTY;
+        board->rows[y] &= (u16)~(1 << hole_x);
+    }
+    rebuild_board_cache(board);
+}
+
+// @note differential check of the row masks and piece tables against the cell by cell reference implementations
+internal
+VERIFY_SIG(verify_collision) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    Game_State game_state = {};
+    
+    for (u64 iteration = 0; iteration < iteration_count; ++iteration) {
+        // @note random board, denser towards the bottom, with some full rows
+        for (int y = 0; y < GRID_HEIGHT; ++y) {
+            b32 make_full = ((next_input_random(&random_state) % 8) == 0);
+            game_state.rows[y] = 0;
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                b32 occupied = make_full || ((int)(next_input_random(&random_state) % GRID_HEIGHT) < y);
+                game_state.grid[y][x] = occupied ? (int)(1 + (next_input_random(&random_state) % (Block_Type::ENUM_SIZE - 1))) : Block_Type::EMPTY;
+                if (occupied)  game_state.rows[y] |= (u16)(1 << x);
+            }
+        }
+        
+        for (int y = 0; y < GRID_HEIGHT; ++y) {
+            VERIFY_CHECK(is_row_full(&game_state, y) == is_row_full_reference(&game_state, y));
+        }
+        
+        // @note table driven probe against the reference checks, for every piece, rotation and origin around the grid
+        if ((iteration % 16) == 0) {
+            for (int type = Block_Type::EMPTY + 1; type < Block_Type::ENUM_SIZE; ++type) {
+                for (u32 rotation = 0; rotation < 4; ++rotation) {
+                    for (int y = -4; y < GRID_HEIGHT + 1; ++y) {
+                        for (int x = -4; x < GRID_WIDTH + 1; ++x) {
+                            Block block = {};
+                            block.type = type;
+                            set_block_placement(&block, x, y, rotation);
+                            b32 expected = !(is_block_out_of_bounds_reference(&block) ||
+                                             is_block_colliding_reference(&game_state, &block));
+                            VERIFY_CHECK((does_piece_fit(&game_state, type, rotation, x, y) != 0) == (expected != 0));
+                        }
+                    }
+                }
+            }
+        }
+        
+        // @note random blocks, partially outside of the grid
+        for (int block_index = 0; block_index < 64; ++block_index) {
+            Block block = {};
+            block.type = Block_Type::T;
+            int base_x = (int)(next_input_random(&random_state) % (GRID_WIDTH + 4)) - 2;
+            int base_y = (int)(next_input_random(&random_state) % (GRID_HEIGHT + 4)) - 2;
+            for (int i = 0; i < 4; ++i) {
+                block.pos[i].x = base_x + (int)(next_input_random(&random_state) % 4) - 1;
+                block.pos[i].y = base_y + (int)(next_input_random(&random_state) % 4);
+            }
+            
+            b32 out_of_bounds = is_block_out_of_bounds(&block);
+            VERIFY_CHECK((out_of_bounds != 0) == (is_block_out_of_bounds_reference(&block) != 0));
+            if (!out_of_bounds) {
+                VERIFY_CHECK((is_block_colliding(&game_state, &block) != 0) == (is_block_colliding_reference(&game_state, &block) != 0));
+            }
+        }
+    }
+    
+    return failure_count;
+}
+
+// @note line clear compaction against the shift per line reference, full rows inside a 4 row window
+internal
+VERIFY_SIG(verify_line_clear) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    
+    for (u64 iteration = 0; iteration < iteration_count; ++iteration) {
+        Game_State compacted = {};
+        for (int y = 0; y < GRID_HEIGHT; ++y) {
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                b32 occupied = ((int)(next_input_random(&random_state) % GRID_HEIGHT) < y);
+                compacted.grid[y][x] = occupied ? (int)(1 + (next_input_random(&random_state) % BAG_SIZE)) : Block_Type::EMPTY;
+                if (occupied)  compacted.rows[y] |= (u16)(1 << x);
+            }
+            // @note no full rows outside of the window
+            int hole_x = (int)(next_input_random(&random_state) % GRID_WIDTH);
+            compacted.grid[y][hole_x] = Block_Type::EMPTY;
+            compacted.rows[y] &= (u16)~(1 << hole_x);
+        }
+        int top_y = (int)(next_input_random(&random_state) % (GRID_HEIGHT - MAX_CLEARED_LINES + 1));
+        int bottom_y = top_y + MAX_CLEARED_LINES - 1;
+        for (int y = top_y; y <= bottom_y; ++y) {
+            if (next_input_random(&random_state) % 2) {
+                for (int x = 0; x < GRID_WIDTH; ++x) {
+                    compacted.grid[y][x] = (int)(1 + (next_input_random(&random_state) % BAG_SIZE));
+                }
+                compacted.rows[y] = FULL_ROW_MASK;
+            }
+        }
+        
+        Game_State reference = compacted;
+        int expected_count = clear_full_lines_reference(&reference);
+        Line_Clear_Result result = clear_full_lines(&compacted, top_y, bottom_y);
+        VERIFY_CHECK(result.count == expected_count);
+        VERIFY_CHECK(memcmp(compacted.grid, reference.grid, sizeof(reference.grid)) == 0);
+        VERIFY_CHECK(do_rows_match_grid(&compacted));
+    }
+    
+    return failure_count;
+}
+
+// @note placement enumeration against the block by block reference, on stacks with holes and overhangs
+internal
+VERIFY_SIG(verify_placements) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    
+    for (u64 iteration = 0; iteration < iteration_count / 8 + 1; ++iteration) {
+        Game_State board;
+        make_random_board(&board, &random_state, GRID_HEIGHT - 2, 6);
+        
+        for (int type = Block_Type::EMPTY + 1; type < Block_Type::ENUM_SIZE; ++type) {
+            local_persist Placement_List placements;
+            local_persist Placement_List expected;
+            enumerate_placements(&board, type, &placements);
+            enumerate_placements_reference(&board, type, &expected);
+            VERIFY_CHECK(placements.count == expected.count);
+            if (placements.count != expected.count)  continue;
+            for (int i = 0; i < placements.count; ++i) {
+                Placement *placement = &placements.placements[i];
+                Placement *reference = &expected.placements[i];
+                VERIFY_CHECK(memcmp(placement->block.pos, reference->block.pos, sizeof(reference->block.pos)) == 0);
+                VERIFY_CHECK(memcmp(placement->rows, reference->rows, sizeof(reference->rows)) == 0);
+                VERIFY_CHECK(placement->lines_cleared == reference->lines_cleared);
+            }
+            // @note the incrementally updated features of every landing board against a full recompute
+            for (int i = 0; i < placements.count; ++i) {
+                Placement *placement = &placements.placements[i];
+                int column_tops[GRID_WIDTH];
+                get_column_tops(placement->rows, column_tops);
+                Board_Features features = get_board_features(placement->rows, column_tops);
+                VERIFY_CHECK(memcmp(&features, &placement->features, sizeof(features)) == 0);
+            }
+            
+            // @note drop distance from random free spots, some of them under overhangs where the lookup has to step
+            for (int probe = 0; probe < 16; ++probe) {
+                Block block = {};
+                block.type = type;
+                u32 rotation = next_input_random(&random_state) % 4;
+                int x = (int)(next_input_random(&random_state) % GRID_WIDTH);
+                int y = (int)(next_input_random(&random_state) % GRID_HEIGHT);
+                if (!does_piece_fit(&board, type, rotation, x, y))  continue;
+                set_block_placement(&block, x, y, rotation);
+                VERIFY_CHECK(get_drop_distance(&board, type, rotation, x, y) == get_drop_distance_reference(&board, &block));
+            }
+        }
+    }
+    
+    return failure_count;
+}
+
+// @note every bag holds each piece exactly once, and identical seeds give identical sequences
+internal
+VERIFY_SIG(verify_generator) {
+    u64 failure_count = 0;
+    
+    for (u64 seed = 0; seed < 64; ++seed) {
+        Piece_Generator a;
+        Piece_Generator b;
+        init_piece_generator(&a, seed);
+        init_piece_generator(&b, seed);
+        for (int bag_index = 0; bag_index < 64; ++bag_index) {
+            u32 seen = 0;
+            for (int i = 0; i < BAG_SIZE; ++i) {
+                enum32(Block_Type) preview = peek_piece(&a, 0);
+                enum32(Block_Type) type = next_piece(&a);
+                VERIFY_CHECK(type == preview);
+                VERIFY_CHECK(type == next_piece(&b));
+                VERIFY_CHECK(type > Block_Type::EMPTY && type < Block_Type::ENUM_SIZE);
+                seen |= (1 << type);
+            }
+            VERIFY_CHECK(seen == (((1 << BAG_SIZE) - 1) << 1));
+        }
+    }
+    
+    return failure_count;
+}
+
+// @note random games keep the occupancy and the board caches in sync, 20G and the gravity speed
+internal
+VERIFY_SIG(verify_simulation) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    Game_State game_state = {};
+    Game_Controller_Input controller = {};
+    
+    // @note simulate some games and check the occupancy and the board caches stay in sync with the color plane
+    init_game(&game_state, 1);
+    for (u64 step = 0; step < iteration_count * 64; ++step) {
+        make_random_input(&controller, &random_state);
+        game_step(&game_state, &controller, 1);
+        VERIFY_CHECK(do_rows_match_grid(&game_state));
+        VERIFY_CHECK(does_board_cache_match_rows(&game_state));
+    }
+    
+    // @note with 20G the current_block always rests on the stack after a tick
+    init_game(&game_state, 6, GAME_TICK_HZ, true);
+    for (u64 step = 0; step < iteration_count * 16; ++step) {
+        make_random_input(&controller, &random_state);
+        game_step(&game_state, &controller, 1);
+        Block *block = &game_state.current_block;
+        VERIFY_CHECK(!does_piece_fit(&game_state, block->type, block->rotation, block->origin.x, block->origin.y + 1));
+        VERIFY_CHECK(does_board_cache_match_rows(&game_state));
+    }
+    
+    // @note gravity runs at the same wall clock speed for every tick rate
+    {
+        u32 tick_rates[] = { 30, GAME_TICK_HZ, 144, 240 };
+        for (int rate_index = 0; rate_index < (int)array_count(tick_rates); ++rate_index) {
+            u32 tick_hz = tick_rates[rate_index];
+            init_game(&game_state, 4, tick_hz);
+            int start_y = game_state.current_block.origin.y;
+            game_step(&game_state, 0, tick_hz);
+            int fallen = game_state.current_block.origin.y - start_y;
+            VERIFY_CHECK(fallen == 1000 / GRAVITY_INTERVAL_MS);
+        }
+    }
+    
+    return failure_count;
+}
+
+// @note every blitter has to produce the same pixels as the per pixel reference, also for clipped blocks
+internal
+VERIFY_SIG(verify_blitters) {
+    u64 failure_count = 0;
+    
+    u32 blit_pixels[WIDTH * HEIGHT];
+    u32 reference_pixels[WIDTH * HEIGHT];
+    Game_Offscreen_Buffer blit = { blit_pixels, WIDTH, HEIGHT, WIDTH * 4, 4 };
+    Game_Offscreen_Buffer reference = { reference_pixels, WIDTH, HEIGHT, WIDTH * 4, 4 };
+    
+    Blit_Tile_Sig *blitters[3] = { blit_tile_scalar, blit_tile_scalar, blit_tile_scalar };
+#if TETRIS_X86
+    Cpu_Features features = get_cpu_features();
+    if (features.sse2)  blitters[1] = blit_tile_sse2;
+    if (features.avx2)  blitters[2] = blit_tile_avx2;
+#endif
+    for (int blitter_index = 0; blitter_index < (int)array_count(blitters); ++blitter_index) {
+        blit_tile = blitters[blitter_index];
+        memset(blit_pixels, 0x55, sizeof(blit_pixels));
+        memset(reference_pixels, 0x55, sizeof(reference_pixels));
+        for (int y = -1; y <= GRID_HEIGHT; ++y) {
+            for (int x = -1; x <= GRID_WIDTH; ++x) {
+                enum32(Block_Type) type = 1 + ((x + y + GRID_WIDTH) % BAG_SIZE);
+                render_block(&blit, Vector2{x,y}, type);
+                render_block_reference(&reference, Vector2{x,y}, type);
+            }
+        }
+        VERIFY_CHECK(memcmp(blit_pixels, reference_pixels, sizeof(reference_pixels)) == 0);
+    }
+    init_renderer();
+    
+    return failure_count;
+}
+
+// @note the incremental renderer has to produce the same pixels as a full redraw
+internal
+VERIFY_SIG(verify_incremental_render) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    Game_State game_state = {};
+    Game_Controller_Input controller = {};
+    
+    u32 incremental_pixels[WIDTH * HEIGHT];
+    u32 full_pixels[WIDTH * HEIGHT];
+    Game_Offscreen_Buffer incremental = { incremental_pixels, WIDTH, HEIGHT, WIDTH * 4, 4 };
+    Game_Offscreen_Buffer full = { full_pixels, WIDTH, HEIGHT, WIDTH * 4, 4 };
+    Render_State incremental_state = {};
+    
+    init_game(&game_state, 2);
+    for (u64 step = 0; step < iteration_count; ++step) {
+        make_random_input(&controller, &random_state);
+        game_step(&game_state, &controller, 1 + (next_input_random(&random_state) % 4));
+        
+        // @note also covers the interpolated current_block drawn between cells
+        f32 tick_alpha = (f32)(next_input_random(&random_state) % 5) / 4.0f;
+        Render_State full_state = {};
+        render_game(&incremental_state, &incremental, &game_state, tick_alpha);
+        render_game(&full_state, &full, &game_state, tick_alpha);
+        VERIFY_CHECK(memcmp(incremental_pixels, full_pixels, sizeof(full_pixels)) == 0);
+    }
+    
+    return failure_count;
+}
+
+// @note rendering at an integer scale has to match the upscaled native render, which also covers the upscalers
+internal
+VERIFY_SIG(verify_scaled_render) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    Game_State game_state = {};
+    Game_Controller_Input controller = {};
+    
+    u32 *native_pixels = (u32 *)malloc(WIDTH * HEIGHT * sizeof(u32));
+    u32 *scaled_pixels = (u32 *)malloc(WIDTH * HEIGHT * MAX_RENDER_SCALE * MAX_RENDER_SCALE * sizeof(u32));
+    u32 *upscaled_pixels = (u32 *)malloc(WIDTH * HEIGHT * MAX_RENDER_SCALE * MAX_RENDER_SCALE * sizeof(u32));
+    Game_Offscreen_Buffer native = { native_pixels, WIDTH, HEIGHT, WIDTH * 4, 4 };
+    
+    int scales[] = { 1, 2, 3, 5, MAX_RENDER_SCALE };
+    for (int scale_index = 0; scale_index < (int)array_count(scales); ++scale_index) {
+        int scale = scales[scale_index];
+        size_t scaled_size = WIDTH * HEIGHT * scale * scale * sizeof(u32);
+        Game_Offscreen_Buffer scaled = { scaled_pixels, WIDTH * scale, HEIGHT * scale, WIDTH * scale * 4, 4 };
+        Game_Offscreen_Buffer upscaled = { upscaled_pixels, WIDTH * scale, HEIGHT * scale, WIDTH * scale * 4, 4 };
+        Render_State scaled_state = {};
+        
+        init_game(&game_state, 3 + scale);
+        u64 step_count = (iteration_count / 16) + 1;
+        for (u64 step = 0; step < step_count; ++step) {
+            make_random_input(&controller, &random_state);
+            game_step(&game_state, &controller, 1 + (next_input_random(&random_state) % 4));
+            
+            Render_State native_state = {};
+            render_game(&native_state, &native, &game_state);
+            render_game(&scaled_state, &scaled, &game_state);
+            
+            upscale_nearest_scalar(&upscaled, &native, scale);
+            VERIFY_CHECK(memcmp(scaled_pixels, upscaled_pixels, scaled_size) == 0);
+#if TETRIS_X86
+            memset(upscaled_pixels, 0x55, scaled_size);
+            upscale_nearest_sse2(&upscaled, &native, scale);
+            VERIFY_CHECK(memcmp(scaled_pixels, upscaled_pixels, scaled_size) == 0);
+#endif
+        }
+    }
+    free(upscaled_pixels);
+    free(scaled_pixels);
+    free(native_pixels);
+    init_renderer();
+    
+    return failure_count;
+}
+
+// @note self-play results only depend on the seeds, not on the worker count or who stole what
+internal
+VERIFY_SIG(verify_selfplay) {
+    u64 failure_count = 0;
+    
+    u32 game_count = 48;
+    Selfplay_Game_Result single_results[48];
+    Selfplay_Game_Result parallel_results[48];
+    init_selfplay_batch(&global_selfplay_batch, 7, game_count, 1, 200, selfplay_policy_random, 0, single_results);
+    run_selfplay_batch(&global_selfplay_batch);
+    Selfplay_Stats single_stats = get_selfplay_stats(&global_selfplay_batch);
+    init_selfplay_batch(&global_selfplay_batch, 7, game_count, 5, 200, selfplay_policy_random, 0, parallel_results);
+    run_selfplay_batch(&global_selfplay_batch);
+    Selfplay_Stats parallel_stats = get_selfplay_stats(&global_selfplay_batch);
+    VERIFY_CHECK(single_stats.game_count == game_count && parallel_stats.game_count == game_count);
+    VERIFY_CHECK(single_stats.pieces == parallel_stats.pieces);
+    VERIFY_CHECK(memcmp(single_results, parallel_results, sizeof(single_results)) == 0);
+    
+    return failure_count;
+}
+
+// @note incremental Zobrist hashes match hashing the landing board, and searching the same game twice gives
+//       the same placement, the reused transposition table must not leak anything from one search into the next
+internal
+VERIFY_SIG(verify_planner) {
+    u64 failure_count = 0;
+    Game_State game_state = {};
+    
+    Planner *planner = (Planner *)aligned_alloc(64, sizeof(Planner));
+    init_planner(planner);
+    Planner_Settings settings = { 3, 16, 0 };
+    init_game(&game_state, 11);
+    for (int piece = 0; piece < 64; ++piece) {
+        u64 board_hash = get_zobrist_hash(&planner->zobrist, game_state.rows);
+        local_persist Placement_List placements;
+        enumerate_placements(&game_state, game_state.current_block.type, &placements);
+        for (int i = 0; i < placements.count; ++i) {
+            VERIFY_CHECK(get_placement_hash(&planner->zobrist, board_hash, &placements.placements[i]) == get_zobrist_hash(&planner->zobrist, placements.placements[i].rows));
+        }
+        
+        Planner_Result first = plan_placement(planner, &game_state, &settings, linux_get_seconds);
+        Planner_Result second = plan_placement(planner, &game_state, &settings, linux_get_seconds);
+        VERIFY_CHECK(first.placement_index >= 0 && first.placement_index == second.placement_index);
+        VERIFY_CHECK(first.completed_depth == settings.depth && first.node_count == second.node_count);
+        if (first.placement_index < 0)  break;
+        lock_placement(&game_state, &first.placement);
+    }
+    free(planner);
+    
+    return failure_count;
+}
+
+// @note Reachability search against the plain reference on stacks with overhangs: the same resting spots at the
+//       same distances, every input sequence replays from spawn to its spot, and every straight drop placement
+//       is reachable. Asking again for the same board and piece comes from the cache.
+internal
+VERIFY_SIG(verify_pathfinder) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    
+    Pathfinder *pathfinder = (Pathfinder *)malloc(sizeof(Pathfinder));
+    init_pathfinder(pathfinder);
+    for (u64 iteration = 0; iteration < iteration_count / 64 + 1; ++iteration) {
+        Game_State board;
+        make_random_board(&board, &random_state, GRID_HEIGHT / 2, 4);
+        
+        for (int type = Block_Type::EMPTY + 1; type < Block_Type::ENUM_SIZE; ++type) {
+            Block start = get_spawn_block(type);
+            u64 miss_count = pathfinder->miss_count;
+            Reachable_Set *set = find_reachable_spots(pathfinder, board.rows, &start);
+            VERIFY_CHECK(find_reachable_spots(pathfinder, board.rows, &start) == set);
+            VERIFY_CHECK(pathfinder->miss_count == miss_count + 1);
+            
+            local_persist Reachable_Set expected;
+            search_reachable_spots_reference(&board, &start, &expected);
+            VERIFY_CHECK(set->count == expected.count);
+            for (int i = 0; i < set->count && i < expected.count; ++i) {
+                Reachable_Spot *spot = &set->spots[i];
+                VERIFY_CHECK(memcmp(&spot->block, &expected.spots[i].block, sizeof(Block)) == 0);
+                VERIFY_CHECK(spot->input_count == expected.spots[i].input_count);
+                
+                Block block = start;
+                for (u32 input = 0; input < spot->input_count; ++input) {
+                    VERIFY_CHECK(apply_path_input(&board, &block, spot->inputs[input]));
+                }
+                VERIFY_CHECK(memcmp(&block, &spot->block, sizeof(Block)) == 0);
+                VERIFY_CHECK(!apply_path_input(&board, &block, PATH_INPUT_DOWN));
+                
+                // @note tucks fill holes, the incremental feature update has to see that too
+                Game_State landed = board;
+                add_block_to_grid(&landed, &block);
+                VERIFY_CHECK(does_board_cache_match_rows(&landed));
+            }
+            
+            local_persist Placement_List placements;
+            enumerate_placements(&board, type, &placements);
+            for (int i = 0; i < placements.count; ++i) {
+                VERIFY_CHECK(find_reachable_spot(set, &placements.placements[i].block));
+            }
+        }
+    }
+    free(pathfinder);
+    
+    return failure_count;
+}
+
+// @note A recorded session has to replay to the same state, seeking has to land on the state the session had
+//       before that step, and a changed recording has to be detected. Held inputs make runs longer than
+//       REPLAY_RUN_LONG, which take the varint repeat count.
+internal
+VERIFY_SIG(verify_replay) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    Game_State game_state = {};
+    Game_Controller_Input controller = {};
+    
+    FILE *file = tmpfile();
+    Replay_Recorder recorder;
+    init_game(&game_state, 5, 144);
+    u64 step_count = 4 * REPLAY_KEYFRAME_INTERVAL + iteration_count;
+    u64 *checksums = (u64 *)malloc((step_count + 1) * sizeof(u64));
+    VERIFY_CHECK(begin_replay_recording(&recorder, file, &game_state));
+    for (u64 step = 0; step < step_count;) {
+        make_random_input(&controller, &random_state);
+        controller.stick_average_x = (f32)(next_input_random(&random_state) % 3) - 1.0f;
+        u32 ticks = next_input_random(&random_state) % 4;
+        u32 hold_count = (next_input_random(&random_state) % 4 == 0) ? 1 + next_input_random(&random_state) % 40 : 1;
+        for (u32 hold = 0; hold < hold_count && step < step_count; ++hold, ++step) {
+            if (ticks)  checksums[recorder.header.step_count] = get_game_state_checksum(&game_state);
+            record_replay_step(&recorder, &game_state, &controller, ticks);
+            game_step(&game_state, &controller, ticks);
+        }
+    }
+    u64 recorded_step_count = recorder.header.step_count;
+    u64 recorded_checksum = get_game_state_checksum(&game_state);
+    checksums[recorded_step_count] = recorded_checksum;
+    VERIFY_CHECK(end_replay_recording(&recorder, &game_state));
+    long file_size = ftell(file);
+    
+    rewind(file);
+    Replay replay;
+    b32 replay_loaded = load_replay(file, &replay);
+    VERIFY_CHECK(replay_loaded);
+    if (replay_loaded) {
+        Game_State replayed;
+        VERIFY_CHECK(replay.header.keyframe_count >= 2);
+        VERIFY_CHECK(play_replay(&replay, &replayed));
+        VERIFY_CHECK(get_game_state_checksum(&replayed) == recorded_checksum);
+        
+        for (u64 i = 0; i < 64; ++i) {
+            u64 step_index = (i == 0) ? recorded_step_count : next_input_random(&random_state) % (recorded_step_count + 1);
+            VERIFY_CHECK(seek_replay(&replay, step_index, &replayed));
+            VERIFY_CHECK(get_game_state_checksum(&replayed) == checksums[step_index]);
+        }
+        VERIFY_CHECK(!seek_replay(&replay, recorded_step_count + 1, &replayed));
+        
+        // @note a changed keyframe and a changed run are caught by a full replay
+        u8 *keyframe = replay.data + replay.keyframes[1].offset;
+        keyframe[offsetof(Snapshot, score)] ^= 1;
+        VERIFY_CHECK(!play_replay(&replay, &replayed));
+        keyframe[offsetof(Snapshot, score)] ^= 1;
+        // @note a keyframe that is no game state is not seeked into, here a piece queue too short to spawn from
+        u8 queue_count = keyframe[offsetof(Snapshot, queue_count)];
+        keyframe[offsetof(Snapshot, queue_count)] = 2;
+        VERIFY_CHECK(!seek_replay(&replay, replay.header.keyframe_interval, &replayed));
+        keyframe[offsetof(Snapshot, queue_count)] = queue_count;
+        VERIFY_CHECK(seek_replay(&replay, replay.header.keyframe_interval, &replayed));
+        u8 *first_run = replay.data + replay.keyframes[0].offset + sizeof(Snapshot);
+        *first_run ^= REPLAY_RUN_FLAGS;
+        VERIFY_CHECK(!play_replay(&replay, &replayed));
+        *first_run ^= REPLAY_RUN_FLAGS;
+        VERIFY_CHECK(play_replay(&replay, &replayed));
+        free_replay(&replay);
+    }
+    
+    // @note a truncated file does not load
+    if (file_size > 1) {
+        rewind(file);
+        u8 *bytes = (u8 *)malloc((size_t)file_size);
+        VERIFY_CHECK(fread(bytes, 1, (size_t)file_size, file) == (size_t)file_size);
+        FILE *truncated = tmpfile();
+        fwrite(bytes, 1, (size_t)file_size - 1, truncated);
+        rewind(truncated);
+        b32 truncated_loaded = load_replay(truncated, &replay);
+        VERIFY_CHECK(!truncated_loaded);
+        if (truncated_loaded)  free_replay(&replay);
+        fclose(truncated);
+        free(bytes);
+    }
+    free(checksums);
+    fclose(file);
+    
+    return failure_count;
+}
+
+// @note Rewinding lands on the state the game had before that step, also after the ring wrapped around and
+//       after rewinding and playing on again. Stepping back one step at a time reaches the oldest step.
+internal
+VERIFY_SIG(verify_rewind) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    Game_State game_state = {};
+    Game_Controller_Input controller = {};
+    
+    u32 keyframe_interval = 16;
+    u64 memory_size = 5 * get_rewind_chunk_size(keyframe_interval);
+    void *memory = malloc((size_t)memory_size);
+    Rewind_Buffer rewind;
+    VERIFY_CHECK(init_rewind_buffer(&rewind, memory, memory_size, keyframe_interval) && rewind.chunk_capacity == 5);
+    Rewind_Buffer too_small;
+    VERIFY_CHECK(!init_rewind_buffer(&too_small, memory, get_rewind_chunk_size(keyframe_interval) - 1, keyframe_interval));
+    
+    u64 step_count = 40 * keyframe_interval + iteration_count;
+    u64 *checksums = (u64 *)malloc((step_count + 1) * sizeof(u64));
+    init_game(&game_state, 11, 144);
+    for (u64 step = 0; step < step_count; ++step) {
+        make_random_input(&controller, &random_state);
+        u32 ticks = next_input_random(&random_state) % 4;
+        if (ticks)  checksums[rewind.step_count] = get_game_state_checksum(&game_state);
+        record_rewind_step(&rewind, &game_state, &controller, ticks);
+        game_step(&game_state, &controller, ticks);
+        checksums[rewind.step_count] = get_game_state_checksum(&game_state);
+        
+        if ((next_input_random(&random_state) % 64) == 0) {
+            u64 history = rewind.step_count - rewind.first_step_index;
+            u64 back = next_input_random(&random_state) % (history + 1);
+            VERIFY_CHECK(rewind_to_step(&rewind, rewind.step_count - back, &game_state));
+            VERIFY_CHECK(get_game_state_checksum(&game_state) == checksums[rewind.step_count]);
+        }
+    }
+    
+    u64 current_checksum = get_game_state_checksum(&game_state);
+    VERIFY_CHECK(rewind.first_step_index == 0 || !rewind_to_step(&rewind, rewind.first_step_index - 1, &game_state));
+    VERIFY_CHECK(get_game_state_checksum(&game_state) == current_checksum);
+    while (rewind.step_count > rewind.first_step_index) {
+        VERIFY_CHECK(rewind_to_step(&rewind, rewind.step_count - 1, &game_state));
+        VERIFY_CHECK(get_game_state_checksum(&game_state) == checksums[rewind.step_count]);
+    }
+    free(checksums);
+    free(memory);
+    
+    return failure_count;
+}
+
+// @note a restored snapshot has the same checksum and keeps playing the same, also with 20G, and a damaged
+//       snapshot or file is rejected
+internal
+VERIFY_SIG(verify_snapshots) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    Game_State game_state = {};
+    Game_Controller_Input controller = {};
+    
+    Game_State restored;
+    Snapshot snapshots[2];
+    for (int mode = 0; mode < 2; ++mode) {
+        init_game(&game_state, 9 + mode, 144, mode == 1);
+        for (u64 step = 0; step < iteration_count * 4; ++step) {
+            make_random_input(&controller, &random_state);
+            game_step(&game_state, &controller, 1 + (next_input_random(&random_state) % 3));
+            if ((step % 7) != 0)  continue;
+            
+            save_snapshot(&game_state, &snapshots[mode]);
+            VERIFY_CHECK(load_snapshot(&snapshots[mode], &restored));
+            VERIFY_CHECK(get_game_state_checksum(&restored) == get_game_state_checksum(&game_state));
+            VERIFY_CHECK(does_board_cache_match_rows(&restored));
+            
+            Game_State original = game_state;
+            u32 input_state = random_state;
+            for (int tick = 0; tick < 32; ++tick) {
+                make_random_input(&controller, &input_state);
+                game_step(&original, &controller, 1);
+                game_step(&restored, &controller, 1);
+            }
+            VERIFY_CHECK(get_game_state_checksum(&restored) == get_game_state_checksum(&original));
+        }
+    }
+    
+    Snapshot damaged = snapshots[0];
+    damaged.current_block.type = Block_Type::EMPTY;
+    VERIFY_CHECK(!load_snapshot(&damaged, &restored));
+    damaged = snapshots[0];
+    damaged.current_block.x = GRID_WIDTH;
+    VERIFY_CHECK(!load_snapshot(&damaged, &restored));
+    damaged = snapshots[0];
+    damaged.queue_count = PREVIEW_COUNT;
+    VERIFY_CHECK(!load_snapshot(&damaged, &restored));
+    // @note an empty piece in the live part of the queue, the last one which is not previewed yet
+    damaged = snapshots[0];
+    u32 last_queue_index = (damaged.queue_read + damaged.queue_count - 1) & (PIECE_QUEUE_SIZE - 1);
+    damaged.packed_queue &= ~((u64)SNAPSHOT_CELL_MASK << (SNAPSHOT_CELL_BITS * last_queue_index));
+    VERIFY_CHECK(!load_snapshot(&damaged, &restored));
+    
+    FILE *file = tmpfile();
+    VERIFY_CHECK(write_snapshot_file(file, snapshots, 2));
+    long size = ftell(file);
+    u8 *memory = (u8 *)malloc((size_t)size);
+    rewind(file);
+    VERIFY_CHECK(fread(memory, 1, (size_t)size, file) == (size_t)size);
+    u64 count;
+    Snapshot *records = get_snapshot_records(memory, (u64)size, &count);
+    VERIFY_CHECK(records && count == 2 && memcmp(records, snapshots, sizeof(snapshots)) == 0);
+    VERIFY_CHECK(!get_snapshot_records(memory, (u64)size - 1, &count));
+    rewind(file);
+    Snapshot first;
+    VERIFY_CHECK(read_snapshot_file(file, &first) && memcmp(&first, &snapshots[0], sizeof(first)) == 0);
+    ((Snapshot_File_Header *)memory)->version = SNAPSHOT_VERSION + 1;
+    VERIFY_CHECK(!get_snapshot_records(memory, (u64)size, &count));
+    free(memory);
+    fclose(file);
+    
+    return failure_count;
+}
+
+// @note The input queue keeps every event in order across threads and only drops when full. Taps between
+//       ticks land on the tick after them and nowhere else, and a game fed from timestamped events at the
+//       tick times plays exactly like one fed the same buttons tick by tick.
+internal
+VERIFY_SIG(verify_input_queue) {
+    u32 random_state = 0x2545F491;
+    u64 failure_count = 0;
+    Game_State game_state = {};
+    
+    Input_Queue *queue = (Input_Queue *)aligned_alloc(INPUT_QUEUE_CACHE_LINE_SIZE, sizeof(Input_Queue));
+    memset(queue, 0, sizeof(Input_Queue));
+    Input_Tracker tracker = {};
+    Game_Input tick_input;
+    for (u32 i = 0; i < INPUT_QUEUE_SIZE; ++i) {
+        Input_Event event = make_input_event(0.0, 4, 0, (i % 2) == 0);
+        VERIFY_CHECK(push_input_event(queue, &event));
+    }
+    Input_Event overflow = make_input_event(0.0, 4, 0, true);
+    VERIFY_CHECK(!push_input_event(queue, &overflow) && queue->dropped_count == 1);
+    VERIFY_CHECK(take_input_events(queue, &tracker, 0.0, &tick_input) == INPUT_QUEUE_SIZE);
+    VERIFY_CHECK(tick_input.controllers[4].buttons[0].half_transition_count == INPUT_QUEUE_SIZE);
+    VERIFY_CHECK(tick_input.controllers[4].buttons[0].ended_down && !tracker.held.controllers[4].buttons[0].ended_down);
+    
+    Input_Event events[] = {
+        make_input_event(0.005, 1, INPUT_EVENT_CONNECTION, true),
+        make_input_event(0.010, 0, get_button_index(move_left), true), // @note tap within the first tick
+        make_input_event(0.012, 0, get_button_index(move_left), false),
+        make_input_event(0.025, 1, get_button_index(back), true), // @note held from the second tick on
+        make_input_event(0.026, 1, get_button_index(back), true), // @note repeats change nothing
+    };
+    for (u32 i = 0; i < array_count(events); ++i) {
+        VERIFY_CHECK(push_input_event(queue, &events[i]));
+    }
+    VERIFY_CHECK(take_input_events(queue, &tracker, 1.0 / 60.0, &tick_input) == 3);
+    VERIFY_CHECK(tick_input.controllers[0].move_left.ended_down && tick_input.controllers[0].move_left.half_transition_count == 2);
+    VERIFY_CHECK(!tracker.held.controllers[0].move_left.ended_down);
+    VERIFY_CHECK(tick_input.controllers[1].is_connected && !tracker.held.controllers[1].back.ended_down);
+    VERIFY_CHECK(take_input_events(queue, &tracker, 2.0 / 60.0, &tick_input) == 2);
+    VERIFY_CHECK(tick_input.controllers[1].back.ended_down && tracker.held.controllers[1].back.ended_down);
+    VERIFY_CHECK(!tick_input.controllers[0].move_left.ended_down);
+    VERIFY_CHECK(take_input_events(queue, &tracker, 3.0 / 60.0, &tick_input) == 0);
+    VERIFY_CHECK(!tick_input.controllers[1].back.ended_down && tracker.held.controllers[1].back.ended_down);
+    
+    // @note every tick's buttons are tapped in the middle of the time before the tick, pushed a few ticks ahead
+    u32 tick_hz = 144;
+    Game_State direct_state;
+    init_game(&game_state, 13, tick_hz);
+    init_game(&direct_state, 13, tick_hz);
+    tracker = {};
+    Tick_Accumulator accumulator = {};
+    Game_Controller_Input tick_controllers[16];
+    u32 input_state = random_state;
+    u64 pushed_tick_count = 0;
+    u64 tick_count = 0;
+    f64 now_seconds = 0.0;
+    for (u64 frame = 0; frame < iteration_count; ++frame) {
+        f64 frame_seconds = 0.001 * (f64)(1 + next_input_random(&random_state) % 40);
+        now_seconds += frame_seconds;
+        while (pushed_tick_count < tick_count + array_count(tick_controllers) &&
+               ((f64)pushed_tick_count + 0.25) / (f64)tick_hz <= now_seconds + 0.01) {
+            Game_Controller_Input *controller = &tick_controllers[pushed_tick_count % array_count(tick_controllers)];
+            make_random_input(controller, &input_state);
+            for (u32 button_index = 0; button_index < array_count(controller->buttons); ++button_index) {
+                if (!controller->buttons[button_index].ended_down)  continue;
+                Input_Event press = make_input_event(((f64)pushed_tick_count + 0.25) / (f64)tick_hz, 0, button_index, true);
+                Input_Event release = make_input_event(((f64)pushed_tick_count + 0.5) / (f64)tick_hz, 0, button_index, false);
+                VERIFY_CHECK(push_input_event(queue, &press) && push_input_event(queue, &release));
+            }
+            ++pushed_tick_count;
+        }
+        
+        u32 ticks = accumulate_ticks(&accumulator, frame_seconds, tick_hz, 1000);
+        for (u32 tick = 0; tick < ticks; ++tick) {
+            f64 tick_seconds = get_tick_seconds(&accumulator, now_seconds, tick_hz, ticks, tick);
+            f64 tick_error = tick_seconds - (f64)(tick_count + 1) / (f64)tick_hz;
+            VERIFY_CHECK(tick_error <= 0.000001 && tick_error >= -0.000001);
+            take_input_events(queue, &tracker, tick_seconds, &tick_input);
+            Game_Controller_Input *direct_controller = &tick_controllers[tick_count % array_count(tick_controllers)];
+            for (u32 button_index = 0; button_index < array_count(direct_controller->buttons); ++button_index) {
+                VERIFY_CHECK(tick_input.controllers[0].buttons[button_index].ended_down == direct_controller->buttons[button_index].ended_down);
+            }
+            game_step(&game_state, &tick_input.controllers[0], 1);
+            game_step(&direct_state, direct_controller, 1);
+            ++tick_count;
+        }
+    }
+    VERIFY_CHECK(get_game_state_checksum(&game_state) == get_game_state_checksum(&direct_state));
+    
+    // @note consumed on this thread while another one produces
+    tracker = {};
+    while (take_input_events(queue, &tracker, 1e30, &tick_input)) {}
+    u64 read_count = queue->read_count;
+    Linux_Input_Producer producer = { queue, 10 * iteration_count + INPUT_QUEUE_SIZE, 0 };
+    u64 dropped_count = queue->dropped_count;
+    pthread_t producer_thread;
+    b32 producer_started = (pthread_create(&producer_thread, 0, linux_input_producer_proc, &producer) == 0);
+    VERIFY_CHECK(producer_started);
+    if (producer_started) {
+        for (u64 i = 0; i < producer.event_count;) {
+            Input_Event event;
+            if (!peek_input_event(queue, &event))  continue;
+            pop_input_event(queue);
+            VERIFY_CHECK(event.seconds == (f64)i && event.controller_index == i % 5);
+            VERIFY_CHECK(event.button_index == i % 12 && event.is_down == (i / 12) % 2);
+            ++i;
+        }
+        pthread_join(producer_thread, 0);
+        VERIFY_CHECK(queue->dropped_count - dropped_count == producer.full_count);
+        VERIFY_CHECK(queue->read_count - read_count == producer.event_count && queue->read_count == queue->write_count);
+    }
+    free(queue);
+    
+    return failure_count;
+}
+
+struct Verify_Entry {
+    const char *name;
+    Verify_Sig *verify;
+};
+
+global Verify_Entry global_verifies[] = {
+    { "collision",          verify_collision },
+    { "line clear",         verify_line_clear },
+    { "placements",         verify_placements },
+    { "generator",          verify_generator },
+    { "simulation",         verify_simulation },
+    { "blitters",           verify_blitters },
+    { "incremental render", verify_incremental_render },
+    { "scaled render",      verify_scaled_render },
+    { "selfplay",           verify_selfplay },
+    { "planner",            verify_planner },
+    { "pathfinder",         verify_pathfinder },
+    { "replay",             verify_replay },
+    { "rewind",             verify_rewind },
+    { "snapshots",          verify_snapshots },
+    { "input queue",        verify_input_queue },
+};
+
+// @note runs every subsystem's checks and sums their failures
+internal int
+run_verify(u64 iteration_count) {
+    init_renderer();
+    u64 failure_count = 0;
+    for (int verify_index = 0; verify_index < (int)array_count(global_verifies); ++verify_index) {
+        Verify_Entry *entry = &global_verifies[verify_index];
+        u64 verify_failure_count = entry->verify(iteration_count);
+        if (verify_failure_count)  printf("verify %s: %llu failures\n", entry->name, (unsigned long long)verify_failure_count);
+        failure_count += verify_failure_count;
+    }
+    if (failure_count > MAX_REPORTED_VERIFY_FAILURES) {
+        printf("verify: only the first %d failures were printed\n", MAX_REPORTED_VERIFY_FAILURES);
+    }
+    
+    printf("verify: %llu iterations, %llu failures\n", (unsigned long long)iteration_count, (unsigned long long)failure_count);
+    return (failure_count == 0) ? 0 : 1;
+}
+
+// @note runs the game in real time like the windowed build, to check the frame scheduler's pacing and cpu use
+global Frame_Log global_frame_log;
+
+// @note The input comes from a synthetic input thread through the input queue and is taken at each tick's time.
+//       With late_latch the queue is read at the input latch, otherwise right at the frame start. The latency
+//       is from reading to the finished render, there is no display to pace the frame to the frame end.
+//       log_path_prefix is optional, with it the frame times are written to <prefix>.csv and <prefix>.json
+internal int
+run_paced(f64 seconds, f64 frame_hz, u32 tick_hz, b32 late_latch, const char *log_path_prefix) {
+    Frame_Scheduler scheduler;
+    init_frame_scheduler(&scheduler, frame_hz, linux_get_seconds, linux_sleep_seconds);
+    
+    Game_State game_state;
+    init_game(&game_state, 1, tick_hz);
+    
+    Input_Queue *queue = (Input_Queue *)aligned_alloc(INPUT_QUEUE_CACHE_LINE_SIZE, sizeof(Input_Queue));
+    memset(queue, 0, sizeof(Input_Queue));
+    Input_Tracker tracker = {};
+    Game_Input tick_input;
+    f64 event_latency_sum = 0.0;
+    Linux_Input_Thread input_thread = { queue, 1, 0x9E3779B9 };
+    pthread_t input_thread_handle;
+    b32 has_input_thread = (pthread_create(&input_thread_handle, 0, linux_input_thread_proc, &input_thread) == 0);
+    
+    u32 *pixels = (u32 *)malloc(WIDTH * HEIGHT * sizeof(u32));
+    Game_Offscreen_Buffer buffer = { pixels, WIDTH, HEIGHT, WIDTH * 4, 4 };
+    Render_State render_state = {};
+    
+    timespec cpu_start;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+    f64 start_seconds = linux_get_seconds();
+    f64 last_simulate_seconds = start_seconds;
+    Tick_Accumulator tick_accumulator = {};
+    u64 last_cycle_count = __rdtsc();
+    while (linux_get_seconds() - start_seconds < seconds) {
+        if (late_latch)  wait_for_input_latch(&scheduler);
+        f64 input_seconds = linux_get_seconds();
+        
+        u32 ticks = accumulate_ticks(&tick_accumulator, input_seconds - last_simulate_seconds, game_state.tick_hz, game_state.tick_hz / 4);
+        last_simulate_seconds = input_seconds;
+        u64 taken_count = tracker.taken_count;
+        f64 taken_seconds_sum = tracker.taken_seconds_sum;
+        for (u32 tick = 0; tick < ticks; ++tick) {
+            f64 tick_seconds = get_tick_seconds(&tick_accumulator, input_seconds, game_state.tick_hz, ticks, tick);
+            take_input_events(queue, &tracker, tick_seconds, &tick_input);
+            game_step(&game_state, &tick_input.controllers[0], 1);
+        }
+        render_game(&render_state, &buffer, &game_state, get_tick_alpha(&tick_accumulator));
+        f64 render_seconds = linux_get_seconds();
+        f64 latency_seconds = render_seconds - input_seconds;
+        event_latency_sum += ((f64)(tracker.taken_count - taken_count) * render_seconds -
+                              (tracker.taken_seconds_sum - taken_seconds_sum));
+        
+        wait_for_frame_end(&scheduler);
+        
+        u64 end_cycle_count = __rdtsc();
+        record_frame_time(&global_frame_log, (f32)(scheduler.stats.last_work_seconds * 1000.0),
+                          (f32)(scheduler.stats.last_frame_seconds * 1000.0), (f32)(latency_seconds * 1000.0),
+                          end_cycle_count - last_cycle_count);
+        last_cycle_count = end_cycle_count;
+#if TETRIS_PROFILE
+        debug_end_frame();
+#endif
+    }
+    f64 seconds_elapsed = linux_get_seconds() - start_seconds;
+    if (has_input_thread) {
+        atomic_store_release_u64(&input_thread.is_running, 0);
+        pthread_join(input_thread_handle, 0);
+    }
+    timespec cpu_end;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+    f64 cpu_seconds = ((f64)(cpu_end.tv_sec - cpu_start.tv_sec) +
+                       (f64)(cpu_end.tv_nsec - cpu_start.tv_nsec) / 1000000000.0);
+    free(pixels);
+    
+    Frame_Stats stats = get_frame_stats(&scheduler);
+    printf("frames:        %llu (%.2f fps, target %.2f)\n", (unsigned long long)stats.frame_count,
+           (f64)stats.frame_count / seconds_elapsed, frame_hz);
+    printf("ticks:         %llu (%.2f ticks/sec, target %u)\n", (unsigned long long)game_state.tick_count,
+           (f64)game_state.tick_count / seconds_elapsed, tick_hz);
+    printf("missed frames: %llu\n", (unsigned long long)stats.missed_frame_count);
+    printf("late frames:   %llu\n", (unsigned long long)stats.late_frame_count);
+    Frame_Log_Summary summary = summarize_frame_log(&global_frame_log);
+    printf("frame ms:      p50 %.2f  p95 %.2f  p99 %.2f  max %.3f\n",
+           summary.frame_ms.p50, summary.frame_ms.p95, summary.frame_ms.p99, summary.frame_ms.max);
+    printf("work ms:       p50 %.2f  p95 %.2f  p99 %.2f  max %.3f\n",
+           summary.work_ms.p50, summary.work_ms.p95, summary.work_ms.p99, summary.work_ms.max);
+    printf("latency ms:    p50 %.2f  p95 %.2f  p99 %.2f  max %.3f (input %s)\n",
+           summary.latency_ms.p50, summary.latency_ms.p95, summary.latency_ms.p99, summary.latency_ms.max,
+           late_latch ? "latched late" : "at the frame start");
+    printf("input events:  %llu taken, %llu dropped, %.2f ms from the event to the render\n",
+           (unsigned long long)tracker.taken_count, (unsigned long long)queue->dropped_count,
+           tracker.taken_count ? (event_latency_sum / (f64)tracker.taken_count) * 1000.0 : 0.0);
+    if (late_latch) {
+        printf("input latch:   %.3f ms into the frame, work estimate %.3f ms\n",
+               stats.last_latch_seconds * 1000.0, stats.work_estimate * 1000.0);
+    }
+    printf("granularity:   %.3f ms\n", stats.sleep_granularity * 1000.0);
+    printf("oversleep:     %.3f ms avg, %.3f ms max, %.3f ms estimate\n",
+           (stats.sleep_count ? stats.total_oversleep / (f64)stats.sleep_count : 0) * 1000.0,
+           stats.max_oversleep * 1000.0, stats.oversleep_estimate * 1000.0);
+    printf("spin:          %.3f ms/frame\n", (stats.total_spin / (f64)stats.frame_count) * 1000.0);
+    printf("cpu:           %.1f%%\n", (cpu_seconds / seconds_elapsed) * 100.0);
+    
+    if (log_path_prefix) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s.csv", log_path_prefix);
+        if (!write_frame_log_csv(&global_frame_log, path))  fprintf(stderr, "could not write %s\n", path);
+        snprintf(path, sizeof(path), "%s.json", log_path_prefix);
+        if (!write_frame_log_json(&global_frame_log, path))  fprintf(stderr, "could not write %s\n", path);
+#if TETRIS_PROFILE
+        // @note tsc rate from the logged frames, they cover the whole run
+        f64 cycles_per_second = (f64)global_frame_log.total_cycles / (global_frame_log.frame_ms.sum / 1000.0);
+        snprintf(path, sizeof(path), "%s.trace.json", log_path_prefix);
+        if (!write_debug_trace_json(path, cycles_per_second))  fprintf(stderr, "could not write %s\n", path);
+#endif
+    }
+    free(queue);
+    return 0;
+}
+
+// @note same synthetic input as the batch run, recorded to path
+internal int
+run_record(const char *path, u64 game_count, u32 ticks_per_step, u64 seed, b32 instant_gravity) {
+    Game_State game_state;
+    init_game(&game_state, seed, GAME_TICK_HZ, instant_gravity);
+    FILE *file = fopen(path, "wb");
+    Replay_Recorder recorder;
+    if (!begin_replay_recording(&recorder, file, &game_state)) {
+        fprintf(stderr, "could not write %s\n", path);
+        if (file)  fclose(file);
+        return 1;
+    }
+    
+    Game_Controller_Input controller = {};
+    u32 random_state = 0x9E3779B9;
+    while (game_state.game_over_count < game_count) {
+        make_random_input(&controller, &random_state);
+        record_replay_step(&recorder, &game_state, &controller, ticks_per_step);
+        game_step(&game_state, &controller, ticks_per_step);
+    }
+    u64 step_count = recorder.header.step_count;
+    b32 written = end_replay_recording(&recorder, &game_state);
+    if (fclose(file) != 0 || !written) {
+        fprintf(stderr, "could not write %s\n", path);
+        return 1;
+    }
+    printf("recorded %llu steps, %llu ticks, checksum %016llx\n", (unsigned long long)step_count,
+           (unsigned long long)game_state.tick_count, (unsigned long long)get_game_state_checksum(&game_state));
+    return 0;
+}
+
+// @note Replays as fast as possible, fails if a keyframe or the final checksum does not match. Then seeks to
+//       random steps, every seek restores a keyframe and simulates the rest of its chunk at most.
+internal int
+run_replay(const char *path, u64 repeat_count) {
+    FILE *file = fopen(path, "rb");
+    Replay replay;
+    b32 loaded = load_replay(file, &replay);
+    if (file)  fclose(file);
+    if (!loaded) {
+        fprintf(stderr, "could not load replay %s\n", path);
+        return 1;
+    }
+    
+    Game_State game_state;
+    b32 matches = true;
+    f64 best_seconds = 0;
+    for (u64 repeat = 0; repeat < repeat_count; ++repeat) {
+        f64 start_seconds = linux_get_seconds();
+        matches &= play_replay(&replay, &game_state);
+        f64 seconds = linux_get_seconds() - start_seconds;
+        if (repeat == 0 || seconds < best_seconds)  best_seconds = seconds;
+    }
+    if (best_seconds <= 0.0)  best_seconds = 1e-9;
+    u64 tick_count = game_state.tick_count;
+    u64 pieces_spawned = game_state.pieces_spawned;
+    u64 checksum = get_game_state_checksum(&game_state);
+    
+    u32 seek_count = 1000;
+    u32 random_state = 0x2545F491;
+    f64 worst_seek_seconds = 0;
+    f64 start_seconds = linux_get_seconds();
+    for (u32 i = 0; i < seek_count; ++i) {
+        f64 seek_start_seconds = linux_get_seconds();
+        u64 step_index = (u64)next_input_random(&random_state) % (replay.header.step_count + 1);
+        matches &= seek_replay(&replay, step_index, &game_state);
+        f64 seek_seconds = linux_get_seconds() - seek_start_seconds;
+        if (seek_seconds > worst_seek_seconds)  worst_seek_seconds = seek_seconds;
+    }
+    f64 seek_seconds = linux_get_seconds() - start_seconds;
+    matches &= seek_replay(&replay, replay.header.step_count, &game_state);
+    matches &= (get_game_state_checksum(&game_state) == checksum);
+    
+    u64 file_size = replay.header.index_offset + replay.header.keyframe_count * sizeof(Replay_Keyframe);
+    printf("steps:         %llu\n", (unsigned long long)replay.header.step_count);
+    printf("ticks:         %llu\n", (unsigned long long)tick_count);
+    printf("pieces:        %llu\n", (unsigned long long)pieces_spawned);
+    printf("file:          %llu bytes, %.2f per step, %u keyframes\n", (unsigned long long)file_size,
+           (f64)file_size / (f64)(replay.header.step_count ? replay.header.step_count : 1), replay.header.keyframe_count);
+    printf("seconds:       %.6f (best of %llu)\n", best_seconds, (unsigned long long)repeat_count);
+    printf("ticks/sec:     %.0f\n", (f64)tick_count / best_seconds);
+    printf("seek:          %.3f ms average, %.3f ms worst\n", seek_seconds * 1000.0 / seek_count, worst_seek_seconds * 1000.0);
+    printf("checksum:      %016llx (%s)\n", (unsigned long long)checksum, matches ? "matches" : "MISMATCH");
+    free_replay(&replay);
+    return matches ? 0 : 1;
+}
+
+// @note Checkpoints count positions of random play, writes them to a snapshot file, maps it and restores every
+//       position from the mapping. The save and load loops are timed as a whole, the checks run afterwards.
+//       Fails if a restored position's checksum differs from the saved one or it does not save to the same record.
+internal int
+run_snapshots(const char *path, u64 count, u64 seed) {
+    // @note count comes from the command line, the sizes must not wrap around
+    b32 fits = (count <= (u64)(SIZE_MAX / sizeof(Snapshot)));
+    Snapshot *snapshots = fits ? (Snapshot *)malloc((size_t)count * sizeof(Snapshot)) : 0;
+    u64 *checksums = fits ? (u64 *)malloc((size_t)count * sizeof(u64)) : 0;
+    if (!snapshots || !checksums) {
+        fprintf(stderr, "could not allocate %llu snapshots\n", (unsigned long long)count);
+        free(snapshots);
+        free(checksums);
+        return 1;
+    }
+    Game_State game_state;
+    init_game(&game_state, seed);
+    Game_Controller_Input controller = {};
+    u32 random_state = 0x9E3779B9;
+    for (u64 i = 0; i < count; ++i) {
+        make_random_input(&controller, &random_state);
+        game_step(&game_state, &controller, 1);
+        checksums[i] = get_game_state_checksum(&game_state);
+        save_snapshot(&game_state, &snapshots[i]);
+    }
+    
+    // @note saves of the final position, the source stays in the cache like it would for a checkpoint every tick
+    f64 start_seconds = linux_get_seconds();
+    for (u64 i = 0; i < count; ++i) {
+        save_snapshot(&game_state, &snapshots[i]);
+    }
+    f64 save_seconds = linux_get_seconds() - start_seconds;
+    
+    // @note the timing loop overwrote the positions, save them again
+    init_game(&game_state, seed);
+    random_state = 0x9E3779B9;
+    for (u64 i = 0; i < count; ++i) {
+        make_random_input(&controller, &random_state);
+        game_step(&game_state, &controller, 1);
+        save_snapshot(&game_state, &snapshots[i]);
+    }
+    
+    start_seconds = linux_get_seconds();
+    FILE *file = fopen(path, "wb");
+    b32 written = write_snapshot_file(file, snapshots, count);
+    if (file && fclose(file) != 0)  written = false;
+    f64 write_seconds = linux_get_seconds() - start_seconds;
+    free(snapshots);
+    if (!written) {
+        fprintf(stderr, "could not write %s\n", path);
+        free(checksums);
+        return 1;
+    }
+    
+    start_seconds = linux_get_seconds();
+    int fd = open(path, O_RDONLY);
+    struct stat file_stat = {};
+    void *memory = MAP_FAILED;
+    if (fd >= 0 && fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+        memory = mmap(0, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (fd >= 0)  close(fd);
+    u64 mapped_count = 0;
+    Snapshot *records = (memory != MAP_FAILED) ? get_snapshot_records(memory, (u64)file_stat.st_size, &mapped_count) : 0;
+    f64 map_seconds = linux_get_seconds() - start_seconds;
+    if (!records || mapped_count != count) {
+        fprintf(stderr, "could not map %s\n", path);
+        if (memory != MAP_FAILED)  munmap(memory, (size_t)file_stat.st_size);
+        free(checksums);
+        return 1;
+    }
+    
+    // @note the first pass also faults the mapping in
+    u64 failure_count = 0;
+    start_seconds = linux_get_seconds();
+    for (u64 i = 0; i < count; ++i) {
+        if (!load_snapshot(&records[i], &game_state))  ++failure_count;
+    }
+    f64 load_seconds = linux_get_seconds() - start_seconds;
+    
+    for (u64 i = 0; i < count; ++i) {
+        Snapshot saved;
+        if (!load_snapshot(&records[i], &game_state) || get_game_state_checksum(&game_state) != checksums[i])  ++failure_count;
+        save_snapshot(&game_state, &saved);
+        if (memcmp(&saved, &records[i], sizeof(saved)) != 0)  ++failure_count;
+    }
+    munmap(memory, (size_t)file_stat.st_size);
+    free(checksums);
+    
+    f64 megabytes = (f64)file_stat.st_size / (1024.0 * 1024.0);
+    if (save_seconds <= 0.0)  save_seconds = 1e-9;
+    if (write_seconds <= 0.0)  write_seconds = 1e-9;
+    if (load_seconds <= 0.0)  load_seconds = 1e-9;
+    printf("snapshots:     %llu of %d bytes (Game_State is %d), %.1f MB\n", (unsigned long long)count,
+           (int)sizeof(Snapshot), (int)sizeof(Game_State), megabytes);
+    printf("save:          %.0f snapshots/sec, %.1f MB/sec\n", (f64)count / save_seconds, megabytes / save_seconds);
+    printf("write:         %.1f MB/sec\n", megabytes / write_seconds);
+    printf("map:           %.3f ms\n", map_seconds * 1000.0);
+    printf("load:          %.0f snapshots/sec, %.1f MB/sec from the mapping\n", (f64)count / load_seconds, megabytes / load_seconds);
+    printf("round trip:    %s\n", failure_count ? "MISMATCH" : "match");
+    return failure_count ? 1 : 0;
+}
+
+// @note the bot plays the live game through game_step, one tick per step like a 60hz frame loop without pacing
+internal int
+run_bot(u64 piece_count, Planner_Settings settings, u64 seed) {
+    Planner *planner = (Planner *)aligned_alloc(64, sizeof(Planner));
+    Pathfinder *pathfinder = (Pathfinder *)malloc(sizeof(Pathfinder));
+    Bot bot;
+    init_bot(&bot, planner, pathfinder, settings);
+    Game_State game_state;
+    init_game(&game_state, seed);
+    
+    u64 plan_count = 0;
+    u64 completed_depth = 0;
+    u64 node_count = 0;
+    u64 merged_count = 0;
+    f64 plan_seconds = 0;
+    f64 max_plan_seconds = 0;
+    f64 start_seconds = linux_get_seconds();
+    while (game_state.pieces_spawned <= piece_count) {
+        u64 planned_piece = bot.planned_piece;
+        Game_Controller_Input controller;
+        get_bot_input(&bot, &game_state, linux_get_seconds, &controller);
+        if (bot.planned_piece != planned_piece) {
+            ++plan_count;
+            completed_depth += bot.last_result.completed_depth;
+            node_count += bot.last_result.node_count;
+            merged_count += bot.last_result.merged_count;
+            plan_seconds += bot.last_result.seconds;
+            if (bot.last_result.seconds > max_plan_seconds)  max_plan_seconds = bot.last_result.seconds;
+        }
+        game_step(&game_state, &controller, 1);
+    }
+    f64 seconds_elapsed = linux_get_seconds() - start_seconds;
+    u64 path_hit_count = pathfinder->hit_count;
+    u64 path_miss_count = pathfinder->miss_count;
+    free(pathfinder);
+    free(planner);
+    if (plan_count == 0)  plan_count = 1;
+    
+    printf("pieces:        %llu\n", (unsigned long long)game_state.pieces_spawned);
+    printf("lines:         %llu (%.3f per piece)\n", (unsigned long long)game_state.lines_cleared,
+           (f64)game_state.lines_cleared / (f64)game_state.pieces_spawned);
+    printf("game overs:    %llu\n", (unsigned long long)game_state.game_over_count);
+    printf("ticks:         %llu\n", (unsigned long long)game_state.tick_count);
+    printf("plan:          %.3f ms avg, %.3f ms max, depth %.2f of %u, width %u\n",
+           (plan_seconds / (f64)plan_count) * 1000.0, max_plan_seconds * 1000.0,
+           (f64)completed_depth / (f64)plan_count, settings.depth, settings.beam_width);
+    printf("boards:        %.1f expanded, %.1f merged per plan\n",
+           (f64)node_count / (f64)plan_count, (f64)merged_count / (f64)plan_count);
+    printf("paths:         %llu searched, %llu cached\n", (unsigned long long)path_miss_count, (unsigned long long)path_hit_count);
+    printf("seconds:       %.3f\n", seconds_elapsed);
+    return 0;
+}
+
+// @note thread_count 0 measures the scaling, the same games with 1, 2, 4, ... threads up to the cpu count
+internal int
+run_selfplay(u32 game_count, u32 thread_count, Selfplay_Policy_Sig *policy, u32 max_pieces, u64 first_seed) {
+    u32 thread_counts[8];
+    u32 run_count = 0;
+    if (thread_count > 0) {
+        thread_counts[run_count++] = thread_count;
+    }
+    else {
+        long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        u32 max_thread_count = (cpu_count < 1) ? 1 : (cpu_count > MAX_SELFPLAY_WORKERS) ? MAX_SELFPLAY_WORKERS : (u32)cpu_count;
+        for (u32 count = 1; count < max_thread_count; count *= 2) {
+            thread_counts[run_count++] = count;
+        }
+        thread_counts[run_count++] = max_thread_count;
+    }
+    
+    Selfplay_Game_Result *results = (Selfplay_Game_Result *)malloc(game_count * sizeof(Selfplay_Game_Result));
+    Selfplay_Game_Result *first_results = (Selfplay_Game_Result *)malloc(game_count * sizeof(Selfplay_Game_Result));
+    b32 results_match = true;
+    f64 first_games_per_second = 0;
+    for (u32 run_index = 0; run_index < run_count; ++run_index) {
+        Selfplay_Batch *batch = &global_selfplay_batch;
+        init_selfplay_batch(batch, first_seed, game_count, thread_counts[run_index], max_pieces, policy, 0, results);
+        f64 seconds = run_selfplay_batch(batch);
+        if (seconds <= 0.0)  seconds = 1e-9;
+        Selfplay_Stats stats = get_selfplay_stats(batch);
+        
+        if (run_index == 0) {
+            memcpy(first_results, results, game_count * sizeof(Selfplay_Game_Result));
+            printf("games:         %llu (%llu stopped at %u pieces)\n", (unsigned long long)stats.game_count,
+                   (unsigned long long)stats.capped_game_count, max_pieces);
+            printf("pieces:        %llu (%.1f per game, max %llu)\n", (unsigned long long)stats.pieces,
+                   (f64)stats.pieces / (f64)stats.game_count, (unsigned long long)stats.max_pieces);
+            printf("lines:         %llu (%.1f per game)\n", (unsigned long long)stats.lines,
+                   (f64)stats.lines / (f64)stats.game_count);
+            printf("score:         %.1f per game\n", (f64)stats.score / (f64)stats.game_count);
+        }
+        else if (memcmp(first_results, results, game_count * sizeof(Selfplay_Game_Result)) != 0) {
+            results_match = false;
+        }
+        
+        // @note speedup against the first run, which is the single thread run when measuring the scaling
+        f64 games_per_second = (f64)stats.game_count / seconds;
+        if (run_index == 0)  first_games_per_second = games_per_second;
+        f64 speedup = games_per_second / first_games_per_second;
+        f64 efficiency = speedup * (f64)thread_counts[0] / (f64)thread_counts[run_index];
+        printf("threads %2u:    %10.1f games/sec  %12.0f pieces/sec  %5.2fx  %3.0f%% efficiency  %llu steals\n",
+               thread_counts[run_index], games_per_second, (f64)stats.pieces / seconds, speedup, efficiency * 100.0,
+               (unsigned long long)stats.steal_count);
+    }
+    free(results);
+    free(first_results);
+    
+    if (!results_match) {
+        printf("results differ between thread counts\n");
+        return 1;
+    }
+    return 0;
+}
+
+int
+main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--verify") == 0) {
+        u64 iteration_count = 100000;
+        if (argc > 2)  iteration_count = strtoull(argv[2], 0, 10);
+        return run_verify(iteration_count);
+    }
+    // @note --paced-early polls input at the frame start instead of at the late input latch
+    if (argc > 1 && (strcmp(argv[1], "--paced") == 0 || strcmp(argv[1], "--paced-early") == 0)) {
+        b32 late_latch = (strcmp(argv[1], "--paced") == 0);
+        f64 seconds = 5.0;
+        f64 frame_hz = 30.0;
+        u32 tick_hz = GAME_TICK_HZ;
+        if (argc > 2)  seconds = strtod(argv[2], 0);
+        if (argc > 3)  frame_hz = strtod(argv[3], 0);
+        if (argc > 4)  tick_hz = (u32)strtoul(argv[4], 0, 10);
+        const char *log_path_prefix = (argc > 5) ? argv[5] : 0;
+        if (seconds <= 0 || frame_hz <= 0 || tick_hz == 0 || tick_hz > MAX_TICK_HZ) {
+            fprintf(stderr, "usage: %s --paced|--paced-early [seconds] [frame_hz] [tick_hz] [log_path_prefix]\n", argv[0]);
+            return 1;
+        }
+        return run_paced(seconds, frame_hz, tick_hz, late_latch, log_path_prefix);
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--selfplay") == 0) {
+        u32 game_count = 1000;
+        u32 thread_count = 0;
+        Selfplay_Policy_Sig *policy = selfplay_policy_random;
+        u32 max_pieces = 10000;
+        u64 first_seed = 1;
+        if (argc > 2)  game_count = (u32)strtoul(argv[2], 0, 10);
+        if (argc > 3)  thread_count = (u32)strtoul(argv[3], 0, 10);
+        if (argc > 4) {
+            policy = 0;
+            for (int policy_index = 0; policy_index < (int)array_count(global_selfplay_policies); ++policy_index) {
+                if (strcmp(argv[4], global_selfplay_policies[policy_index].name) == 0)  policy = global_selfplay_policies[policy_index].policy;
+            }
+        }
+        if (argc > 5)  max_pieces = (u32)strtoul(argv[5], 0, 10);
+        if (argc > 6)  first_seed = strtoull(argv[6], 0, 10);
+        if (game_count == 0 || thread_count > MAX_SELFPLAY_WORKERS || !policy || max_pieces == 0) {
+            fprintf(stderr, "usage: %s --selfplay [game_count] [thread_count] [random|heuristic] [max_pieces] [first_seed]\n"
+                    "       thread_count 0 measures the scaling from 1 thread up to the cpu count\n", argv[0]);
+            return 1;
+        }
+        return run_selfplay(game_count, thread_count, policy, max_pieces, first_seed);
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--bot") == 0) {
+        u64 piece_count = 1000;
+        Planner_Settings settings = { 3, 32, 0.002 };
+        u64 seed = 1;
+        if (argc > 2)  piece_count = strtoull(argv[2], 0, 10);
+        if (argc > 3)  settings.depth = (u32)strtoul(argv[3], 0, 10);
+        if (argc > 4)  settings.beam_width = (u32)strtoul(argv[4], 0, 10);
+        if (argc > 5)  settings.budget_seconds = strtod(argv[5], 0) / 1000.0;
+        if (argc > 6)  seed = strtoull(argv[6], 0, 10);
+        if (piece_count == 0 || settings.depth == 0 || settings.depth > MAX_SEARCH_DEPTH ||
+            settings.beam_width == 0 || settings.beam_width > MAX_BEAM_WIDTH || settings.budget_seconds < 0) {
+            fprintf(stderr, "usage: %s --bot [piece_count] [depth 1-%d] [beam_width 1-%d] [budget_ms, 0 for none] [seed]\n",
+                    argv[0], MAX_SEARCH_DEPTH, MAX_BEAM_WIDTH);
+            return 1;
+        }
+        return run_bot(piece_count, settings, seed);
+    }
+    
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0) {
+        u64 repeat_count = 1;
+        if (argc > 3)  repeat_count = strtoull(argv[3], 0, 10);
+        if (repeat_count == 0)  repeat_count = 1;
+        return run_replay(argv[2], repeat_count);
+    }
+    
+    if (argc > 2 && strcmp(argv[1], "--snapshots") == 0) {
+        u64 count = 100000;
+        u64 seed = 1;
+        if (argc > 3)  count = strtoull(argv[3], 0, 10);
+        if (argc > 4)  seed = strtoull(argv[4], 0, 10);
+        if (count == 0)  count = 1;
+        return run_snapshots(argv[2], count, seed);
+    }
+    
+    // @note --20g drops every piece onto the stack right away, for the batch run and recordings
+    b32 instant_gravity = false;
+    if (argc > 1 && strcmp(argv[1], "--20g") == 0) {
+        instant_gravity = true;
+        --argc;
+        ++argv;
+    }
+    
+    // @note --record path takes the batch arguments after the path
+    const char *record_path = 0;
+    if (argc > 2 && strcmp(argv[1], "--record") == 0) {
+        record_path = argv[2];
+        argc -= 2;
+        argv += 2;
+    }
+    
+    u64 game_count = 1000;
+    u32 ticks_per_step = 1;
+    u64 seed = 1;
+    if (argc > 1)  game_count = strtoull(argv[1], 0, 10);
+    if (argc > 2)  ticks_per_step = (u32)strtoul(argv[2], 0, 10);
+    if (argc > 3)  seed = strtoull(argv[3], 0, 10);
+    if (record_path && game_count && ticks_per_step)  return run_record(record_path, game_count, ticks_per_step, seed, instant_gravity);
+    if (game_count == 0 || ticks_per_step == 0) {
+        fprintf(stderr, "usage: %s [--20g] [game_count] [ticks_per_step] [seed]\n       %s --verify [iteration_count]\n       %s --paced|--paced-early [seconds] [frame_hz] [tick_hz] [log_path_prefix]\n"
+                "       %s [--20g] --record path [game_count] [ticks_per_step] [seed]\n       %s --replay path [repeat_count]\n"
+                "       %s --selfplay [game_count] [thread_count] [random|heuristic] [max_pieces] [first_seed]\n"
+                "       %s --bot [piece_count] [depth] [beam_width] [budget_ms] [seed]\n       %s --snapshots path [count] [seed]\n",
+                argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return 1;
+    }
+    
+    Game_State game_state;
+    init_game(&game_state, seed, GAME_TICK_HZ, instant_gravity);
+    
+    Game_Controller_Input controller = {};
+    u32 random_state = 0x9E3779B9;
+    
+    f64 start_seconds = linux_get_seconds();
+    while (game_state.game_over_count < game_count) {
+        make_random_input(&controller, &random_state);
+        game_step(&game_state, &controller, ticks_per_step);
+    }
+    f64 seconds_elapsed = linux_get_seconds() - start_seconds;
+    if (seconds_elapsed <= 0.0)  seconds_elapsed = 1e-9;
+    
+    printf("games:         %llu\n", (unsigned long long)game_state.game_over_count);
+    printf("ticks:         %llu\n", (unsigned long long)game_state.tick_count);
+    printf("pieces:        %llu\n", (unsigned long long)game_state.pieces_spawned);
+    printf("lines:         %llu\n", (unsigned long long)game_state.lines_cleared);
+    printf("seconds:       %.3f\n", seconds_elapsed);
+    printf("ticks/sec:     %.0f\n", (f64)game_state.tick_count / seconds_elapsed);
+    printf("pieces/sec:    %.0f\n", (f64)game_state.pieces_spawned / seconds_elapsed);
+    printf("games/sec:     %.2f\n", (f64)game_state.game_over_count / seconds_elapsed);
+    
+    return 0;
+}
@@ -0,0 +1,619 @@
+#include "tetris.h"
+#include "tetris_pieces.h"
+
+
+// @note is_block_colliding expects the block to be inside the grid, check is_block_out_of_bounds first
+internal b32
+is_block_colliding(Game_State *game_state, Block *block) {
+    // @note build the row masks of the block, a block spans at most 4 rows
+    int min_y = block->pos[0].y;
+    for (int i = 1; i < 4; ++i) {
+        if (block->pos[i].y < min_y)  min_y = block->pos[i].y;
+    }
+    u16 block_rows[4] = {};
+    for (int i = 0; i < 4; ++i) {
+        block_rows[block->pos[i].y - min_y] |= (u16)(1 << block->pos[i].x);
+    }
+    
+    u16 overlap = 0;
+    for (int row = 0; row < 4; ++row) {
+        if (block_rows[row])  overlap |= (game_state->rows[min_y + row] & block_rows[row]);
+    }
+    b32 hit = (overlap != 0);
+    return hit;
+}
+
+internal b32
+is_block_out_of_bounds(Block *block) {
+    // @note negative coordinates wrap around to huge unsigned values
+    b32 out_of_bounds = false;
+    for (int i = 0; i < 4; ++i) {
+        out_of_bounds |= (((u32)block->pos[i].x >= GRID_WIDTH) |
+                          ((u32)block->pos[i].y >= GRID_HEIGHT));
+    }
+    return out_of_bounds;
+}
+
+inline b32
+is_row_full(Game_State *game_state, int y) {
+    b32 result = (game_state->rows[y] == FULL_ROW_MASK);
+    return result;
+}
+
+//
+// @note cell by cell reference implementations, only used to cross check the row masks (see linux_tetris_headless --verify)
+//
+
+internal b32
+is_block_colliding_reference(Game_State *game_state, Block *block) {
+    b32 hit = false;
+    for (int i = 0; i < 4; ++i) {
+        if (game_state->grid[block->pos[i].y][block->pos[i].x] != Block_Type::EMPTY)  {
+            hit = true;
+            break;
+        }
+    }
+    return hit;
+}
+
+internal b32
+is_block_out_of_bounds_reference(Block *block) {
+    b32 out_of_bounds = false;
+    for (int i = 0; i < 4; ++i) {
+        if ((block->pos[i].y >= 0            &&
+             block->pos[i].y <  GRID_HEIGHT) &&
+            (block->pos[i].x >= 0            &&
+             block->pos[i].x <  GRID_WIDTH)) {
+            // inside grid
+        }
+        else {
+            out_of_bounds = true;
+            break;
+        }
+    }
+    return out_of_bounds;
+}
+
+internal b32
+is_row_full_reference(Game_State *game_state, int y) {
+    b32 line_full = true;
+    for (int x = 0; x < GRID_WIDTH; ++x) {
+        if (game_state->grid[y][x] == Block_Type::EMPTY) {
+            line_full = false;
+        }
+    }
+    return line_full;
+}
+
+// @note shifts the whole stack for every full line and checks the same line again afterwards
+internal int
+clear_full_lines_reference(Game_State *game_state) {
+    int cleared_count = 0;
+    for (int current_line = GRID_HEIGHT-1; current_line >= 0; --current_line) {
+        if (is_row_full_reference(game_state, current_line))  {
+            ++cleared_count;
+            for (int y = current_line-1; y >= 0; --y) {
+                for (int x = 0; x < GRID_WIDTH; ++x) {
+                    game_state->grid[y+1][x] = game_state->grid[y][x];
+                }
+            }
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                game_state->grid[0][x] = Block_Type::EMPTY;
+            }
+            ++current_line;
+        }
+    }
+    return cleared_count;
+}
+
+internal b32
+do_rows_match_grid(Game_State *game_state) {
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        u16 row = 0;
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            if (game_state->grid[y][x] != Block_Type::EMPTY)  row |= (u16)(1 << x);
+        }
+        if (row != game_state->rows[y])  return false;
+    }
+    return true;
+}
+
+// @note row of the highest occupied cell in every column, GRID_HEIGHT for empty columns
+internal void
+get_column_tops(u16 *rows, int *column_tops) {
+    for (int x = 0; x < GRID_WIDTH; ++x) {
+        column_tops[x] = GRID_HEIGHT;
+    }
+    u16 seen = 0;
+    for (int y = 0; y < GRID_HEIGHT && seen != FULL_ROW_MASK; ++y) {
+        u32 new_columns = rows[y] & ~seen;
+        while (new_columns) {
+            column_tops[find_least_significant_set_bit(new_columns)] = y;
+            new_columns &= new_columns - 1;
+        }
+        seen |= rows[y];
+    }
+}
+
+//
+// @note board features, kept up to date with the rows (see add_piece_to_board)
+//
+
+inline int
+get_row_transitions(u16 row) {
+    u32 bits = ((u32)row << 1) | 1 | (1 << (GRID_WIDTH + 1)); // @note with the walls
+    int result = count_set_bits((bits ^ (bits >> 1)) & ((1 << (GRID_WIDTH + 1)) - 1));
+    return result;
+}
+
+// @note changes between row y and the row below it, below the last row is the floor
+inline int
+get_column_transitions(u16 *rows, int y) {
+    u16 below = (y + 1 < GRID_HEIGHT) ? rows[y + 1] : FULL_ROW_MASK;
+    int result = count_set_bits((rows[y] ^ below) & FULL_ROW_MASK);
+    return result;
+}
+
+inline int
+get_column_height(int *column_tops, int x) {
+    int result = (x >= 0 && x < GRID_WIDTH) ? GRID_HEIGHT - column_tops[x] : GRID_HEIGHT;
+    return result;
+}
+
+// @note bumpiness of the column pairs starting in [first_x, last_x) and the wells of the columns in [first_x, last_x]
+internal void
+add_surface_features(Board_Features *features, int *column_tops, int first_x, int last_x, int sign) {
+    for (int x = first_x; x <= last_x; ++x) {
+        int height = get_column_height(column_tops, x);
+        if (x < last_x) {
+            int step = height - get_column_height(column_tops, x + 1);
+            features->bumpiness += sign * ((step < 0) ? -step : step);
+        }
+        int left = get_column_height(column_tops, x - 1);
+        int right = get_column_height(column_tops, x + 1);
+        int depth = ((left < right) ? left : right) - height;
+        if (depth > 0)  features->wells += sign * depth;
+    }
+}
+
+// @note the row transitions of rows [first_y, last_y] and the column transitions from those rows to the row below
+internal void
+add_transition_features(Board_Features *features, u16 *rows, int first_y, int last_y, int sign) {
+    for (int y = first_y; y <= last_y; ++y) {
+        features->row_transitions += sign * get_row_transitions(rows[y]);
+        features->column_transitions += sign * get_column_transitions(rows, y);
+    }
+}
+
+// @note full recompute from the rows and their column tops
+internal Board_Features
+get_board_features(u16 *rows, int *column_tops) {
+    Board_Features result = {};
+    for (int x = 0; x < GRID_WIDTH; ++x) {
+        int height = get_column_height(column_tops, x);
+        result.aggregate_height += height;
+        if (height > result.max_height)  result.max_height = height;
+    }
+    add_surface_features(&result, column_tops, 0, GRID_WIDTH - 1, 1);
+    add_transition_features(&result, rows, 0, GRID_HEIGHT - 1, 1);
+    
+    u16 covered = 0;
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        result.holes += count_set_bits(covered & ~rows[y] & FULL_ROW_MASK);
+        covered |= rows[y];
+    }
+    return result;
+}
+
+// @note Locks a piece into rows and updates column_tops and features in place, the line clear is up to the caller.
+//       Only the piece's columns and rows and their neighbours change, the old terms of those are taken out and
+//       the new ones put back in. New holes are the empty cells between a column's old and new top.
+internal void
+add_piece_to_board(u16 *rows, int *column_tops, Board_Features *features, enum32(Block_Type) type, u32 rotation, int x, int y) {
+    const Piece_Orientation *orientation = &piece_orientations[type][rotation];
+    int left = x + orientation->min_x;
+    int right = x + orientation->max_x;
+    int top = y + orientation->min_y;
+    int bottom = y + orientation->max_y;
+    int first_x = (left > 0) ? left - 1 : 0;
+    int last_x = (right < GRID_WIDTH - 1) ? right + 1 : GRID_WIDTH - 1;
+    int first_y = (top > 0) ? top - 1 : 0; // @note row top - 1 has a column transition to row top
+    
+    add_surface_features(features, column_tops, first_x, last_x, -1);
+    add_transition_features(features, rows, first_y, bottom, -1);
+    
+    int old_tops[4];
+    for (int c = 0; c <= right - left; ++c) {
+        old_tops[c] = column_tops[left + c];
+    }
+    for (int i = 0; i < 4; ++i) {
+        int mino_x = x + orientation->minos[i].x;
+        int mino_y = y + orientation->minos[i].y;
+        if (mino_y > old_tops[mino_x - left])  --features->holes; // @note tucked under an overhang, fills a hole
+        if (mino_y < column_tops[mino_x])  column_tops[mino_x] = mino_y;
+        rows[mino_y] |= (u16)(1 << mino_x);
+    }
+    for (int c = 0; c <= right - left; ++c) {
+        int new_top = column_tops[left + c];
+        if (new_top >= old_tops[c])  continue;
+        features->aggregate_height += old_tops[c] - new_top;
+        int height = GRID_HEIGHT - new_top;
+        if (height > features->max_height)  features->max_height = height;
+        for (int hole_y = new_top + 1; hole_y < old_tops[c]; ++hole_y) {
+            if (!(rows[hole_y] & (1 << (left + c))))  ++features->holes;
+        }
+    }
+    
+    add_surface_features(features, column_tops, first_x, last_x, 1);
+    add_transition_features(features, rows, first_y, bottom, 1);
+}
+
+// @note for boards whose rows were written directly and after line clears, otherwise the caches follow the rows
+internal void
+rebuild_board_cache(Game_State *game_state) {
+    get_column_tops(game_state->rows, game_state->column_tops);
+    game_state->features = get_board_features(game_state->rows, game_state->column_tops);
+}
+
+internal b32
+does_board_cache_match_rows(Game_State *game_state) {
+    int column_tops[GRID_WIDTH];
+    get_column_tops(game_state->rows, column_tops);
+    Board_Features features = get_board_features(game_state->rows, column_tops);
+    b32 result = (memcmp(column_tops, game_state->column_tops, sizeof(column_tops)) == 0 &&
+                  memcmp(&features, &game_state->features, sizeof(features)) == 0);
+    return result;
+}
+
+//
+// @note table driven placement, see tetris_pieces.h
+//
+
+// @note combined bounds and collision probe for a piece at the given origin, one AND per occupied row
+internal b32
+does_piece_fit(Game_State *game_state, enum32(Block_Type) type, u32 rotation, int x, int y) {
+    const Piece_Orientation *orientation = &piece_orientations[type][rotation];
+    int left   = x + orientation->min_x;
+    int top    = y + orientation->min_y;
+    if (left < 0 || x + orientation->max_x >= GRID_WIDTH)  return false;
+    if (top  < 0 || y + orientation->max_y >= GRID_HEIGHT)  return false;
+    
+    int row_count = orientation->max_y - orientation->min_y + 1;
+    u16 overlap = 0;
+    for (int row = 0; row < row_count; ++row) {
+        overlap |= (game_state->rows[top + row] & (u16)(orientation->row_masks[row] << left));
+    }
+    b32 fits = (overlap == 0);
+    return fits;
+}
+
+internal void
+set_block_placement(Block *block, int x, int y, u32 rotation) {
+    const Piece_Orientation *orientation = &piece_orientations[block->type][rotation];
+    block->rotation = rotation;
+    block->origin = {x, y};
+    for (int i = 0; i < 4; ++i) {
+        block->pos[i].x = x + orientation->minos[i].x;
+        block->pos[i].y = y + orientation->minos[i].y;
+    }
+}
+
+// @note Rows a piece at the given origin can fall straight down. Everything above a column's top cell is empty, so
+//       while the piece is above the stack it lands where its lowest mino first meets a column top, one lookup per
+//       column. Only a piece tucked under an overhang starts below a top cell, then it is stepped down with does_piece_fit.
+internal int
+get_drop_distance(Game_State *game_state, enum32(Block_Type) type, u32 rotation, int x, int y) {
+    const Piece_Orientation *orientation = &piece_orientations[type][rotation];
+    int left = x + orientation->min_x;
+    int width = orientation->max_x - orientation->min_x + 1;
+    int drop_y = GRID_HEIGHT;
+    for (int c = 0; c < width; ++c) {
+        int column_y = game_state->column_tops[left + c] - 1 - orientation->column_bottoms[c];
+        if (column_y < drop_y)  drop_y = column_y;
+    }
+    
+    if (drop_y < y) {
+        drop_y = y;
+        while (does_piece_fit(game_state, type, rotation, x, drop_y + 1))  ++drop_y;
+    }
+    int result = drop_y - y;
+    return result;
+}
+
+// @note tries to move the block by the given offset, returns false and leaves the block untouched if it doesn't fit
+internal b32
+try_move_block(Game_State *game_state, Block *block, int dx, int dy) {
+    int x = block->origin.x + dx;
+    int y = block->origin.y + dy;
+    b32 moved = does_piece_fit(game_state, block->type, block->rotation, x, y);
+    if (moved)  set_block_placement(block, x, y, block->rotation);
+    return moved;
+}
+
+// @note SRS rotation, probes at most KICK_COUNT kick offsets and takes the first one that fits
+internal b32
+rotate_block(Game_State *game_state, Block *block, b32 clockwise) {
+    u32 new_rotation = (block->rotation + (clockwise ? 1 : 3)) & 3;
+    u32 kick_set = kick_set_by_type[block->type];
+    const Vector2 *kicks = kick_offsets[kick_set][block->rotation][clockwise ? 0 : 1];
+    
+    for (int kick_index = 0; kick_index < kick_count_by_set[kick_set]; ++kick_index) {
+        int x = block->origin.x + kicks[kick_index].x;
+        int y = block->origin.y + kicks[kick_index].y;
+        if (does_piece_fit(game_state, block->type, new_rotation, x, y)) {
+            set_block_placement(block, x, y, new_rotation);
+            return true;
+        }
+    }
+    return false;
+}
+
+// @note step by step on is_block_out_of_bounds and is_block_colliding, only used to cross check get_drop_distance
+internal int
+get_drop_distance_reference(Game_State *game_state, Block *block) {
+    int result = 0;
+    for (;;) {
+        Block moved = *block;
+        set_block_placement(&moved, moved.origin.x, moved.origin.y + result + 1, moved.rotation);
+        if (is_block_out_of_bounds(&moved) || is_block_colliding(game_state, &moved))  break;
+        ++result;
+    }
+    return result;
+}
+
+internal void
+make_new_current_block(Game_State *game_state) {
+    enum32(Block_Type) type = next_piece(&game_state->piece_generator);
+    game_state->current_block.type = type;
+    
+    // @note spawn centered, with the top most row of the piece in the first grid row
+    int spawn_x = SPAWN_X;
+    int spawn_y = -piece_orientations[type][0].min_y;
+    set_block_placement(&game_state->current_block, spawn_x, spawn_y, 0);
+    game_state->previous_block = game_state->current_block; // @note a new piece is not interpolated
+    ++game_state->pieces_spawned;
+    
+    b32 hit = !does_piece_fit(game_state, type, 0, spawn_x, spawn_y);
+    if (hit)  {
+        // @note game over
+        ++game_state->game_over_count;
+        reset_game(game_state);
+    }
+}
+
+internal void
+reset_game(Game_State *game_state) {
+    // clear grid
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        game_state->rows[y] = 0;
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            game_state->grid[y][x] = Block_Type::EMPTY;
+        }
+    }
+    rebuild_board_cache(game_state);
+    game_state->gravity_tick_counter = 0;
+    game_state->score = 0;
+    
+    make_new_current_block(game_state);
+}
+
+// @note the piece sequence is fully determined by the seed, the generator keeps running across game overs
+internal void
+init_game(Game_State *game_state, u64 seed, u32 tick_hz, b32 instant_gravity) {
+    assert(tick_hz > 0 && tick_hz <= MAX_TICK_HZ);
+    *game_state = {};
+    game_state->seed = seed;
+    game_state->tick_hz = tick_hz;
+    game_state->instant_gravity = instant_gravity;
+    game_state->gravity_interval_ticks = (GRAVITY_INTERVAL_MS * tick_hz) / 1000;
+    if (game_state->gravity_interval_ticks == 0)  game_state->gravity_interval_ticks = 1;
+    init_piece_generator(&game_state->piece_generator, seed);
+    reset_game(game_state);
+}
+
+internal void
+move_current_block_left(Game_State *game_state) {
+    try_move_block(game_state, &game_state->current_block, -1, 0);
+}
+
+internal void
+move_current_block_right(Game_State *game_state) {
+    try_move_block(game_state, &game_state->current_block, 1, 0);
+}
+
+internal void
+add_block_to_grid(Game_State *game_state, Block *block) {
+    for (int i = 0; i < 4; ++i) {
+        game_state->grid[block->pos[i].y][block->pos[i].x] = block->type;
+    }
+    add_piece_to_board(game_state->rows, game_state->column_tops, &game_state->features,
+                       block->type, block->rotation, block->origin.x, block->origin.y);
+#if TETRIS_SLOW
+    assert(does_board_cache_match_rows(game_state));
+#endif
+}
+
+// @note guideline scoring for single, double, triple and tetris
+global constexpr u32 line_clear_score[MAX_CLEARED_LINES + 1] = { 0, 100, 300, 500, 800 };
+
+static_assert(Block_Type::EMPTY == 0, "clear_full_lines clears the grid with memset");
+
+// @note Single pass compaction. Only rows in [top_y, bottom_y] are checked, the caller passes the rows
+//       of the block that just locked, no other row can become full.
+//       Every surviving row above the bottom most full row is moved down exactly once.
+internal Line_Clear_Result
+clear_full_lines(Game_State *game_state, int top_y, int bottom_y) {
+    TIMED_BLOCK("line clear");
+    assert(top_y >= 0 && bottom_y < GRID_HEIGHT && (bottom_y - top_y) < MAX_CLEARED_LINES);
+    
+    Line_Clear_Result result = {};
+    for (int y = bottom_y; y >= top_y; --y) {
+        if (is_row_full(game_state, y))  result.rows[result.count++] = y;
+    }
+    if (result.count == 0)  return result;
+    
+    // @note move the runs of surviving rows between full rows, from the bottom up.
+    //       The run above full row i drops down by i+1 rows.
+    for (int i = 0; i < result.count; ++i) {
+        int run_bottom = result.rows[i] - 1;
+        int run_top = (i + 1 < result.count) ? result.rows[i + 1] + 1 : 0;
+        int run_count = run_bottom - run_top + 1;
+        if (run_count <= 0)  continue;
+        
+        int shift = i + 1;
+        memmove(&game_state->rows[run_top + shift], &game_state->rows[run_top], run_count * sizeof(game_state->rows[0]));
+        memmove(&game_state->grid[run_top + shift], &game_state->grid[run_top], run_count * sizeof(game_state->grid[0]));
+    }
+    
+    // @note the top rows got moved down and are empty now
+    memset(&game_state->rows[0], 0, result.count * sizeof(game_state->rows[0]));
+    memset(&game_state->grid[0], 0, result.count * sizeof(game_state->grid[0]));
+    
+    // @note a column's top cell can be in a cleared row and every row moved, the caches are rebuilt from the rows
+    rebuild_board_cache(game_state);
+    
+    game_state->lines_cleared += result.count;
+    game_state->score += line_clear_score[result.count];
+    
+    return result;
+}
+
+internal Line_Clear_Result
+lock_block_and_spawn_next(Game_State *game_state, Block *block) {
+    add_block_to_grid(game_state, block);
+    
+    const Piece_Orientation *orientation = &piece_orientations[block->type][block->rotation];
+    Line_Clear_Result result = clear_full_lines(game_state,
+                                                block->origin.y + orientation->min_y,
+                                                block->origin.y + orientation->max_y);
+    make_new_current_block(game_state);
+    return result;
+}
+
+// @note moves the current_block onto the stack without locking it
+internal void
+drop_current_block(Game_State *game_state) {
+    Block *block = &game_state->current_block;
+    int distance = get_drop_distance(game_state, block->type, block->rotation, block->origin.x, block->origin.y);
+    if (distance > 0)  set_block_placement(block, block->origin.x, block->origin.y + distance, block->rotation);
+}
+
+internal Line_Clear_Result
+hard_drop_current_block(Game_State *game_state) {
+    drop_current_block(game_state);
+    Block landed_block = game_state->current_block;
+    Line_Clear_Result result = lock_block_and_spawn_next(game_state, &landed_block);
+    return result;
+}
+
+internal void
+apply_gravity(Game_State *game_state) {
+    // @note move the current_block downward, if it hit the bottom or other blocks it gets locked
+    b32 moved = try_move_block(game_state, &game_state->current_block, 0, 1);
+    if (!moved)  {
+        Block landed_block = game_state->current_block;
+        lock_block_and_spawn_next(game_state, &landed_block);
+    }
+}
+
+// @note Advances the simulation by ticks fixed ticks. The input is applied at the start of the first tick,
+//       with ticks == 0 nothing happens and the platform layer keeps the input (see merge_controller_input).
+internal void
+game_step(Game_State *game_state, const Game_Controller_Input *controller, u32 ticks) {
+    TIMED_BLOCK("simulate");
+    for (u32 tick = 0; tick < ticks; ++tick) {
+        game_state->previous_block = game_state->current_block;
+        
+        //
+        // @note do input
+        //
+        
+        // @note every move is validated with does_piece_fit, the current_block never overlaps the grid
+        if (controller && tick == 0) {
+            if (controller->move_up.ended_down) {
+                hard_drop_current_block(game_state);
+            }
+            else if (controller->move_left.ended_down) {
+                move_current_block_left(game_state);
+            }
+            else if (controller->move_down.ended_down) {
+                try_move_block(game_state, &game_state->current_block, 0, 1);
+            }
+            else if (controller->move_right.ended_down) {
+                move_current_block_right(game_state);
+            }
+            else if (controller->action_right.ended_down || controller->action_down.ended_down) {
+                b32 clockwise = (controller->action_down.ended_down) ? true : false;
+                rotate_block(game_state, &game_state->current_block, clockwise);
+            }
+        }
+        
+        //
+        // @note simulate
+        //
+        
+        ++game_state->tick_count;
+        ++game_state->gravity_tick_counter;
+        if (game_state->gravity_tick_counter >= game_state->gravity_interval_ticks) {
+            game_state->gravity_tick_counter = 0;
+            apply_gravity(game_state);
+        }
+        if (game_state->instant_gravity)  drop_current_block(game_state);
+    }
+}
+
+// @note FNV-1a, only used for state checksums
+inline u64
+hash_bytes(u64 hash, const void *data, size_t size) {
+    const u8 *at = (const u8 *)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= at[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+#define HASH_VALUE(hash, value) hash_bytes((hash), &(value), sizeof(value))
+
+inline u64
+hash_block(u64 hash, Block *block) {
+    for (int i = 0; i < 4; ++i) {
+        hash = HASH_VALUE(hash, block->pos[i].x);
+        hash = HASH_VALUE(hash, block->pos[i].y);
+    }
+    hash = HASH_VALUE(hash, block->type);
+    hash = HASH_VALUE(hash, block->rotation);
+    hash = HASH_VALUE(hash, block->origin.x);
+    hash = HASH_VALUE(hash, block->origin.y);
+    return hash;
+}
+
+// @note Checksum of everything that influences future simulation, field by field so struct padding does not matter.
+//       Two runs that agree on it will keep agreeing given the same input, replays use it to detect desyncs.
+internal u64
+get_game_state_checksum(Game_State *game_state) {
+    u64 hash = 0xCBF29CE484222325ULL;
+    hash = hash_block(hash, &game_state->current_block);
+    hash = hash_block(hash, &game_state->previous_block);
+    hash = hash_bytes(hash, game_state->rows, sizeof(game_state->rows));
+    hash = hash_bytes(hash, game_state->grid, sizeof(game_state->grid));
+    hash = HASH_VALUE(hash, game_state->tick_hz);
+    hash = HASH_VALUE(hash, game_state->gravity_interval_ticks);
+    hash = HASH_VALUE(hash, game_state->gravity_tick_counter);
+    hash = HASH_VALUE(hash, game_state->instant_gravity);
+    hash = HASH_VALUE(hash, game_state->score);
+    hash = HASH_VALUE(hash, game_state->seed);
+    
+    Piece_Generator *generator = &game_state->piece_generator;
+    hash = HASH_VALUE(hash, generator->series.state);
+    hash = HASH_VALUE(hash, generator->series.increment);
+    hash = hash_bytes(hash, generator->queue, sizeof(generator->queue));
+    hash = HASH_VALUE(hash, generator->queue_read);
+    hash = HASH_VALUE(hash, generator->queue_count);
+    
+    hash = HASH_VALUE(hash, game_state->tick_count);
+    hash = HASH_VALUE(hash, game_state->pieces_spawned);
+    hash = HASH_VALUE(hash, game_state->lines_cleared);
+    hash = HASH_VALUE(hash, game_state->game_over_count);
+    return hash;
+}
@@ -0,0 +1,242 @@
+#if !defined(TETRIS_H)
+
+// @note Platform independent game layer, no windows.h in here!
+//       The platform layer includes tetris.cpp (unity build) and drives the
+//       simulation through game_step.
+
+// @note crt and intrinsics headers have to come before iml_types.h, it redefines inline
+#include <string.h> // @note memmove, memcpy, memset
+#include <stdio.h>  // @note fopen for the debug exports
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TETRIS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define TETRIS_X86 0
+#endif
+
+#include "iml_general.h"
+#include "iml_types.h"
+
+#include "tetris_intrinsics.h"
+#include "tetris_debug.h"
+#include "tetris_random.h"
+
+
+#define GRID_WIDTH 10
+#define GRID_HEIGHT 20
+
+// @note one bit per cell, bit x is set if grid[y][x] is occupied
+#define FULL_ROW_MASK ((u16)((1 << GRID_WIDTH) - 1))
+
+// @note new pieces spawn with the top left of their bounding box here, centered
+#define SPAWN_X ((GRID_WIDTH / 2) - 1)
+
+// @note a piece spans at most 4 rows, so one lock can clear at most 4 lines
+#define MAX_CLEARED_LINES 4
+
+// @note The simulation advances in fixed ticks, the platform layer converts wall clock time to ticks.
+//       The tick rate is picked at startup (init_game), gravity is converted to ticks from milliseconds.
+#define GAME_TICK_HZ 60 // @note default tick rate
+#define MAX_TICK_HZ 1000
+#define GRAVITY_INTERVAL_MS 200
+
+
+struct Vector2 {
+    int x;
+    int y;
+};
+typedef Vector2 v2;
+
+struct Vector3 {
+    union {
+        struct {
+            u32 x;
+            u32 y;
+            u32 z;
+        };
+        struct {
+            u32 r;
+            u32 g;
+            u32 b;
+        };
+    };
+};
+typedef Vector3 v3;
+
+internal Vector3
+rgb(u32 r, u32 g, u32 b) {
+    Vector3 rgb { r, g, b };
+    return rgb;
+}
+
+enum Block_Type {
+    EMPTY = 0,
+    
+    // @note descriptions from wikipedia:https://tetris.wiki/Tetromino
+    I, // Light blue; shaped like a capital I; four Minos in a straight line. Other names include straight, stick, and long. This is the only tetromino that can clear four lines outside of cascade games.
+    O, // Yellow; a square shape; four Minos in a 2×2 square. Other names include square and block.
+    T, // Purple; shaped like a capital T; a row of three Minos with one added above the center.
+    S, // Green; shaped like a capital S; two stacked horizontal diminos with the top one offset to the right. Other names include inverse skew and right snake.
+    Z, // Red; shaped like a capital Z; two stacked horizontal diminos with the top one offset to the left. Other names include skew and left snake.
+    J, // Blue; shaped like a capital J; a row of three Minos with one added above the left side. Other names include gamma, inverse L, or left gun.
+    L, // Orange; shaped like a capital L; a row of three Minos with one added above the right side. Other names include right gun.
+    
+    ENUM_SIZE,
+};
+typedef bool __check_bag_size__[BAG_SIZE == (Block_Type::ENUM_SIZE - 1) ? 1 : -1];
+
+struct Block {
+    Vector2 pos[4]; // @note grid positions of the minos, always origin + piece_orientations[type][rotation]
+    enum32(Block_Type) type;
+    u32 rotation; // @note 0 = spawn orientation, 1 = clockwise, 2 = 180, 3 = counter clockwise
+    Vector2 origin; // @note top left of the orientation's bounding box in grid coordinates
+};
+
+// @note classic hand tuned evaluation inputs, computed from the occupancy only
+struct Board_Features {
+    int aggregate_height;   // @note sum of the column heights
+    int max_height;
+    int holes;              // @note empty cells with an occupied cell somewhere above them in the same column
+    int bumpiness;          // @note sum of the height differences between neighbouring columns
+    int wells;              // @note sum of how far each column lies below its lower neighbour, the walls count as full height
+    int row_transitions;    // @note occupied/empty changes along every row, the walls count as occupied
+    int column_transitions; // @note occupied/empty changes down every column, the floor counts as occupied
+};
+
+struct Game_State {
+    Block current_block;
+    Block previous_block; // @note current_block at the start of the last tick, the renderer interpolates between the two
+    u16 rows[GRID_HEIGHT]; // @note occupancy, used for collision and line checks
+    int column_tops[GRID_WIDTH]; // @note row of the highest occupied cell per column, GRID_HEIGHT if empty, follows rows
+    Board_Features features;     // @note of rows, follows them like column_tops
+    int grid[GRID_HEIGHT][GRID_WIDTH]; // @note color plane, only used for rendering @todo enum for the color of the block
+    
+    u32 tick_hz;
+    u32 gravity_interval_ticks;
+    u32 gravity_tick_counter;
+    b32 instant_gravity; // @note 20G, the piece falls to the stack every tick and the gravity interval becomes the lock delay
+    u64 score;
+    
+    u64 seed;
+    Piece_Generator piece_generator;
+    
+    // @note statistics, never reset by reset_game
+    u64 tick_count;
+    u64 pieces_spawned;
+    u64 lines_cleared;
+    u64 game_over_count;
+};
+
+struct Line_Clear_Result {
+    int count;
+    int rows[MAX_CLEARED_LINES]; // @note grid rows before compaction, bottom most first
+};
+
+struct Game_Button_State {
+    b32 ended_down;
+    b32 allow_press;
+    int half_transition_count;
+};
+
+struct Game_Controller_Input {
+    b32 is_connected;
+    b32 is_analog;
+    f32 stick_average_x;
+    f32 stick_average_y;
+    
+    union {
+        Game_Button_State buttons[12];
+        
+        struct {
+            Game_Button_State move_up;
+            Game_Button_State move_down;
+            Game_Button_State move_left;
+            Game_Button_State move_right;
+            
+            Game_Button_State action_up;
+            Game_Button_State action_down;
+            Game_Button_State action_left;
+            Game_Button_State action_right;
+            
+            Game_Button_State left_shoulder;
+            Game_Button_State right_shoulder;
+            
+            Game_Button_State start;
+            Game_Button_State back;
+            
+            // @note all buttons must be added to the struct above this line!!!
+            Game_Button_State _terminator_;
+        };
+    };
+};
+
+struct Game_Input {
+    Game_Controller_Input controllers[5];
+};
+
+inline Game_Controller_Input *
+get_controller(Game_Input *input, u32 controller_index) {
+    assert(controller_index < array_count(input->controllers));
+    return &input->controllers[controller_index];
+}
+
+// @note Input only takes effect on tick boundaries. Presses from frames without a tick are merged
+//       into a pending input, so they are applied on the next tick instead of getting lost.
+inline void
+merge_controller_input(Game_Controller_Input *pending, const Game_Controller_Input *input) {
+    pending->is_connected |= input->is_connected;
+    pending->is_analog = input->is_analog;
+    pending->stick_average_x = input->stick_average_x;
+    pending->stick_average_y = input->stick_average_y;
+    for (int button_index = 0; button_index < (int)array_count(pending->buttons); ++button_index) {
+        pending->buttons[button_index].ended_down |= input->buttons[button_index].ended_down;
+        pending->buttons[button_index].half_transition_count += input->buttons[button_index].half_transition_count;
+    }
+}
+
+// @note converts variable frame times to fixed ticks, the leftover fraction of a tick is the interpolation factor
+struct Tick_Accumulator {
+    f64 ticks;
+};
+
+// @note more than max_ticks is dropped, after a long hitch the game slows down instead of spiraling
+inline u32
+accumulate_ticks(Tick_Accumulator *accumulator, f64 seconds_elapsed, u32 tick_hz, u32 max_ticks) {
+    accumulator->ticks += seconds_elapsed * (f64)tick_hz;
+    u32 ticks = (u32)accumulator->ticks;
+    if (ticks > max_ticks) {
+        ticks = max_ticks;
+        accumulator->ticks = (f64)max_ticks;
+    }
+    accumulator->ticks -= (f64)ticks;
+    return ticks;
+}
+
+// @note When tick tick_index of the ticks accumulate_ticks just returned at now_seconds came due, the last one
+//       is the leftover fraction of a tick ago. Timestamped input up to then belongs to that tick.
+inline f64
+get_tick_seconds(Tick_Accumulator *accumulator, f64 now_seconds, u32 tick_hz, u32 ticks, u32 tick_index) {
+    f64 ticks_ago = accumulator->ticks + (f64)(ticks - 1 - tick_index);
+    f64 result = now_seconds - ticks_ago / (f64)tick_hz;
+    return result;
+}
+
+// @note 0 right at the last tick, approaching 1 shortly before the next one
+inline f32
+get_tick_alpha(Tick_Accumulator *accumulator) {
+    f32 result = (f32)accumulator->ticks;
+    return result;
+}
+
+
+internal void init_game(Game_State *game_state, u64 seed, u32 tick_hz = GAME_TICK_HZ, b32 instant_gravity = false);
+internal void reset_game(Game_State *game_state);
+internal void game_step(Game_State *game_state, const Game_Controller_Input *controller, u32 ticks);
+
+
+#define TETRIS_H
+#endif
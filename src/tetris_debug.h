@@ -0,0 +1,194 @@
+#if !defined(TETRIS_DEBUG_H)
+
+// @note Profiling with scoped timing blocks, compiled in with TETRIS_PROFILE=1 (build.bat does for the debug build).
+//       Every TIMED_BLOCK site gets a static record through __COUNTER__, no allocation and no lookup.
+//       The records collect cycles and hits during a frame, debug_end_frame moves them into the frame history.
+//       Every block is also logged as an event for the trace export (chrome://tracing, ui.perfetto.dev).
+
+
+#if !defined(TETRIS_PROFILE)
+#define TETRIS_PROFILE 0
+#endif
+
+// @note TETRIS_SLOW=1 turns on expensive consistency checks, e.g. the board caches against a full recompute after every change
+#if !defined(TETRIS_SLOW)
+#define TETRIS_SLOW 0
+#endif
+
+#if TETRIS_PROFILE && TETRIS_X86
+
+#define MAX_DEBUG_RECORDS 64
+#define DEBUG_EVENT_COUNT 65536 // @note power of two, ring of the most recent blocks
+#define DEBUG_FRAME_COUNT 128   // @note power of two, ring of per frame totals
+
+struct Debug_Record {
+    const char *name;
+    const char *file;
+    u32 line;
+    volatile u64 cycles;    // @note since the last debug_end_frame
+    volatile u64 hit_count;
+};
+
+struct Debug_Event {
+    u64 begin_cycles;
+    u64 end_cycles;
+    u32 record_index;
+};
+
+struct Debug_Frame_Record {
+    u64 cycles;
+    u64 hit_count;
+};
+
+struct Debug_Frame {
+    u64 begin_cycles;
+    u64 end_cycles;
+    Debug_Frame_Record records[MAX_DEBUG_RECORDS];
+};
+
+struct Debug_State {
+    Debug_Record records[MAX_DEBUG_RECORDS];
+    u32 record_count; // @note one past the highest record index seen
+    
+    Debug_Event events[DEBUG_EVENT_COUNT];
+    volatile u64 event_count;
+    
+    Debug_Frame frames[DEBUG_FRAME_COUNT];
+    u64 frame_count;
+    u64 frame_begin_cycles;
+};
+
+global Debug_State global_debug_state;
+
+inline u64
+begin_timed_block(u32 record_index, const char *name, const char *file, u32 line) {
+    assert(record_index < MAX_DEBUG_RECORDS);
+    Debug_Record *record = &global_debug_state.records[record_index];
+    record->name = name;
+    record->file = file;
+    record->line = line;
+    if (global_debug_state.record_count <= record_index)  global_debug_state.record_count = record_index + 1;
+    u64 result = __rdtsc();
+    return result;
+}
+
+inline void
+end_timed_block(u32 record_index, u64 begin_cycles) {
+    u64 end_cycles = __rdtsc();
+    Debug_Record *record = &global_debug_state.records[record_index];
+    atomic_add_u64(&record->cycles, end_cycles - begin_cycles);
+    atomic_add_u64(&record->hit_count, 1);
+    
+    u64 event_index = atomic_add_u64(&global_debug_state.event_count, 1);
+    Debug_Event *event = &global_debug_state.events[event_index & (DEBUG_EVENT_COUNT - 1)];
+    event->begin_cycles = begin_cycles;
+    event->end_cycles = end_cycles;
+    event->record_index = record_index;
+}
+
+#define TIMED_BLOCK__(name, counter) \
+    u64 CONCAT(timed_block_begin_, counter) = begin_timed_block(counter, name, __FILE__, __LINE__); \
+    defer { end_timed_block(counter, CONCAT(timed_block_begin_, counter)); }
+#define TIMED_BLOCK_(name, counter) TIMED_BLOCK__(name, counter)
+#define TIMED_BLOCK(name) TIMED_BLOCK_(name, __COUNTER__)
+
+// @note call once per frame from the platform layer, after everything that should count for this frame
+internal void
+debug_end_frame() {
+    Debug_State *state = &global_debug_state;
+    u64 end_cycles = __rdtsc();
+    Debug_Frame *frame = &state->frames[state->frame_count & (DEBUG_FRAME_COUNT - 1)];
+    frame->begin_cycles = state->frame_begin_cycles ? state->frame_begin_cycles : end_cycles;
+    frame->end_cycles = end_cycles;
+    for (u32 record_index = 0; record_index < MAX_DEBUG_RECORDS; ++record_index) {
+        Debug_Record *record = &state->records[record_index];
+        frame->records[record_index].cycles = atomic_exchange_u64(&record->cycles, 0);
+        frame->records[record_index].hit_count = atomic_exchange_u64(&record->hit_count, 0);
+    }
+    ++state->frame_count;
+    state->frame_begin_cycles = end_cycles;
+}
+
+// @note the last completed frame, 0 before the first debug_end_frame
+inline Debug_Frame *
+get_last_debug_frame() {
+    Debug_State *state = &global_debug_state;
+    if (state->frame_count == 0)  return 0;
+    Debug_Frame *result = &state->frames[(state->frame_count - 1) & (DEBUG_FRAME_COUNT - 1)];
+    return result;
+}
+
+// @note __FILE__ is a windows path with backslashes in the msvc build
+internal void
+write_json_string(FILE *file, const char *string) {
+    fputc('"', file);
+    for (const char *at = string; *at; ++at) {
+        if (*at == '"' || *at == '\\')  fputc('\\', file);
+        fputc(*at, file);
+    }
+    fputc('"', file);
+}
+
+// @note Chrome trace event format, complete events for the blocks and one per frame.
+//       Timed blocks still running on other threads while this runs can show up garbled, good enough for debugging.
+internal b32
+write_debug_trace_json(const char *path, f64 cycles_per_second) {
+    FILE *file = fopen(path, "wb");
+    if (!file)  return false;
+    
+    Debug_State *state = &global_debug_state;
+    u64 event_count = atomic_load_acquire_u64(&state->event_count);
+    u64 first_event = (event_count > DEBUG_EVENT_COUNT) ? event_count - DEBUG_EVENT_COUNT : 0;
+    u64 frame_count = state->frame_count;
+    u64 first_frame = (frame_count > DEBUG_FRAME_COUNT) ? frame_count - DEBUG_FRAME_COUNT : 0;
+    
+    // @note timestamps relative to the oldest thing in the trace, events are logged when they end so nested
+    //       blocks come before the block around them
+    u64 base_cycles = ~0ull;
+    for (u64 event_index = first_event; event_index < event_count; ++event_index) {
+        u64 begin_cycles = state->events[event_index & (DEBUG_EVENT_COUNT - 1)].begin_cycles;
+        if (begin_cycles < base_cycles)  base_cycles = begin_cycles;
+    }
+    if (first_frame < frame_count) {
+        u64 frame_begin = state->frames[first_frame & (DEBUG_FRAME_COUNT - 1)].begin_cycles;
+        if (frame_begin < base_cycles)  base_cycles = frame_begin;
+    }
+    f64 microseconds_per_cycle = 1000000.0 / cycles_per_second;
+    
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"frames\"}},\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"timed blocks\"}}");
+    for (u64 frame_index = first_frame; frame_index < frame_count; ++frame_index) {
+        Debug_Frame *frame = &state->frames[frame_index & (DEBUG_FRAME_COUNT - 1)];
+        if (frame->begin_cycles < base_cycles)  continue;
+        fprintf(file, ",\n{\"name\":\"frame %llu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                (unsigned long long)frame_index,
+                (f64)(frame->begin_cycles - base_cycles) * microseconds_per_cycle,
+                (f64)(frame->end_cycles - frame->begin_cycles) * microseconds_per_cycle);
+    }
+    for (u64 event_index = first_event; event_index < event_count; ++event_index) {
+        Debug_Event *event = &state->events[event_index & (DEBUG_EVENT_COUNT - 1)];
+        if (event->begin_cycles < base_cycles || event->end_cycles < event->begin_cycles)  continue;
+        Debug_Record *record = &state->records[event->record_index];
+        fprintf(file, ",\n{\"name\":");
+        write_json_string(file, record->name);
+        fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"file\":",
+                (f64)(event->begin_cycles - base_cycles) * microseconds_per_cycle,
+                (f64)(event->end_cycles - event->begin_cycles) * microseconds_per_cycle);
+        write_json_string(file, record->file);
+        fprintf(file, ",\"line\":%u}}", record->line);
+    }
+    fprintf(file, "\n]}\n");
+    b32 result = (fclose(file) == 0);
+    return result;
+}
+
+#else
+
+#define TIMED_BLOCK(name)
+
+#endif
+
+
+#define TETRIS_DEBUG_H
+#endif
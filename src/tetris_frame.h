@@ -0,0 +1,173 @@
+#if !defined(TETRIS_FRAME_H)
+
+// @note Platform independent frame scheduler. The platform layer provides a high resolution clock and
+//       a sleep, the scheduler sleeps in coarse steps until shortly before the frame ends and only spins
+//       for the rest. How much the os oversleeps is measured at startup and tracked while running.
+//       With late latching the frame's work is moved to its end: wait_for_input_latch waits until the work is
+//       expected to just fit before the frame end, then the platform layer polls input, simulates and presents.
+//       That only gets the input to the screen sooner if the display takes the frame at the frame end, e.g. a
+//       flip at vsync. A present that shows the frame right away, like the GDI blit of the win32 layer, gains
+//       nothing from it, the poll is as close to the present in both cases.
+
+
+#define PLATFORM_GET_SECONDS_SIG(name) f64 name()
+typedef PLATFORM_GET_SECONDS_SIG(Platform_Get_Seconds_Sig);
+
+// @note may return early or late, the scheduler measures what actually happened
+#define PLATFORM_SLEEP_SECONDS_SIG(name) void name(f64 seconds)
+typedef PLATFORM_SLEEP_SECONDS_SIG(Platform_Sleep_Seconds_Sig);
+
+// @note time that is always left for spinning, covers the jitter the oversleep estimate does not catch
+#define FRAME_SPIN_SECONDS 0.0002
+#define FRAME_GRANULARITY_SAMPLE_COUNT 8
+// @note kept free between the expected end of the work and the frame end, a frame's work varies
+#define FRAME_LATCH_MARGIN_SECONDS 0.001
+
+struct Frame_Stats {
+    u64 frame_count;
+    u64 missed_frame_count;  // @note frames whose work alone took longer than the target
+    u64 late_frame_count;    // @note frames that ended late because a sleep overshot
+    u64 sleep_count;
+    f64 sleep_granularity;   // @note shortest sleep the os actually does, measured at startup
+    f64 oversleep_estimate;  // @note current safety margin in front of the frame end
+    f64 max_oversleep;
+    f64 total_oversleep;
+    f64 total_sleep;
+    f64 total_spin;
+    f64 last_work_seconds;   // @note time from the frame start or the input latch to wait_for_frame_end
+    f64 last_frame_seconds;
+    f64 work_estimate;       // @note how long the work after the input latch takes
+    f64 last_latch_seconds;  // @note time from the frame start to the input latch
+};
+
+struct Frame_Scheduler {
+    f64 target_seconds_per_frame;
+    f64 frame_start;
+    Platform_Get_Seconds_Sig *get_seconds;
+    Platform_Sleep_Seconds_Sig *sleep_seconds;
+    b32 is_latched;          // @note wait_for_input_latch was called this frame
+    f64 latch_seconds;
+    Frame_Stats stats;
+};
+
+internal void
+record_oversleep(Frame_Scheduler *scheduler, f64 oversleep) {
+    Frame_Stats *stats = &scheduler->stats;
+    if (oversleep < 0)  oversleep = 0;
+    stats->total_oversleep += oversleep;
+    if (oversleep > stats->max_oversleep)  stats->max_oversleep = oversleep;
+    
+    // @note Jump up to any worse oversleep right away, decay slowly so one good sleep does not cause a late frame.
+    //       Capped at half a frame, a preempted sleep would otherwise stop all sleeping and with it the decay.
+    if (oversleep > stats->oversleep_estimate)  stats->oversleep_estimate = oversleep;
+    else  stats->oversleep_estimate += (oversleep - stats->oversleep_estimate) * 0.1;
+    f64 max_estimate = 0.5 * scheduler->target_seconds_per_frame;
+    if (stats->oversleep_estimate > max_estimate)  stats->oversleep_estimate = max_estimate;
+}
+
+// @note measures the sleep granularity, so call it once at startup and not in the frame loop
+internal void
+init_frame_scheduler(Frame_Scheduler *scheduler, f64 target_hz,
+                     Platform_Get_Seconds_Sig *get_seconds, Platform_Sleep_Seconds_Sig *sleep_seconds) {
+    *scheduler = {};
+    scheduler->target_seconds_per_frame = 1.0 / target_hz;
+    scheduler->get_seconds = get_seconds;
+    scheduler->sleep_seconds = sleep_seconds;
+    
+    // @note the shortest sleep tells the granularity, the longest one is the starting oversleep estimate
+    f64 granularity = 0;
+    for (int sample = 0; sample < FRAME_GRANULARITY_SAMPLE_COUNT; ++sample) {
+        f64 start = get_seconds();
+        sleep_seconds(0.0001);
+        f64 slept = get_seconds() - start;
+        if (sample == 0 || slept < granularity)  granularity = slept;
+        if (slept > scheduler->stats.oversleep_estimate)  scheduler->stats.oversleep_estimate = slept;
+    }
+    if (scheduler->stats.oversleep_estimate > 0.5 * scheduler->target_seconds_per_frame) {
+        scheduler->stats.oversleep_estimate = 0.5 * scheduler->target_seconds_per_frame;
+    }
+    scheduler->stats.sleep_granularity = granularity;
+    scheduler->stats.work_estimate = 0.5 * scheduler->target_seconds_per_frame; // @note settles within a second
+    scheduler->frame_start = get_seconds();
+}
+
+// @note Sleeps while the oversleep estimate allows it and spins for the rest. Updates now to the time it
+//       returned at, false if a sleep overshot the target.
+internal b32
+wait_until(Frame_Scheduler *scheduler, f64 target, f64 *now) {
+    Frame_Stats *stats = &scheduler->stats;
+    for (;;) {
+        f64 sleep_seconds = (target - *now) - stats->oversleep_estimate - FRAME_SPIN_SECONDS;
+        if (sleep_seconds < stats->sleep_granularity)  break;
+        
+        scheduler->sleep_seconds(sleep_seconds);
+        f64 after_sleep = scheduler->get_seconds();
+        ++stats->sleep_count;
+        stats->total_sleep += after_sleep - *now;
+        record_oversleep(scheduler, (after_sleep - *now) - sleep_seconds);
+        *now = after_sleep;
+    }
+    if (*now > target)  return false;
+    
+    f64 spin_start = *now;
+    while (*now < target) {
+        *now = scheduler->get_seconds();
+    }
+    stats->total_spin += *now - spin_start;
+    return true;
+}
+
+// @note Blocks until the work of the frame is expected to end FRAME_LATCH_MARGIN_SECONDS before the frame end,
+//       call it right before polling input. Returns right away if the work does not fit anymore. The latch
+//       also keeps the oversleep estimate free, a late latch would turn into a missed frame.
+internal void
+wait_for_input_latch(Frame_Scheduler *scheduler) {
+    Frame_Stats *stats = &scheduler->stats;
+    f64 frame_end = scheduler->frame_start + scheduler->target_seconds_per_frame;
+    f64 latch = frame_end - stats->work_estimate - stats->oversleep_estimate - FRAME_LATCH_MARGIN_SECONDS;
+    f64 now = scheduler->get_seconds();
+    if (now < latch)  wait_until(scheduler, latch, &now);
+    scheduler->is_latched = true;
+    scheduler->latch_seconds = now;
+    stats->last_latch_seconds = now - scheduler->frame_start;
+}
+
+// @note Blocks until the current frame's target time is reached and starts the next frame.
+//       Frames keep a fixed cadence, after a missed frame the cadence restarts from now.
+internal void
+wait_for_frame_end(Frame_Scheduler *scheduler) {
+    Frame_Stats *stats = &scheduler->stats;
+    f64 frame_end = scheduler->frame_start + scheduler->target_seconds_per_frame;
+    f64 now = scheduler->get_seconds();
+    f64 work_start = scheduler->is_latched ? scheduler->latch_seconds : scheduler->frame_start;
+    stats->last_work_seconds = now - work_start;
+    
+    // @note like the oversleep, a slower frame raises the estimate right away and faster ones lower it slowly
+    if (scheduler->is_latched) {
+        if (stats->last_work_seconds > stats->work_estimate)  stats->work_estimate = stats->last_work_seconds;
+        else  stats->work_estimate += (stats->last_work_seconds - stats->work_estimate) * 0.05;
+        scheduler->is_latched = false;
+    }
+    
+    if (now >= frame_end) {
+        ++stats->missed_frame_count;
+    }
+    else if (!wait_until(scheduler, frame_end, &now)) {
+        ++stats->late_frame_count;
+    }
+    
+    stats->last_frame_seconds = now - scheduler->frame_start;
+    ++stats->frame_count;
+    if (now - frame_end < scheduler->target_seconds_per_frame)  scheduler->frame_start = frame_end;
+    else                                                        scheduler->frame_start = now;
+}
+
+inline Frame_Stats
+get_frame_stats(Frame_Scheduler *scheduler) {
+    Frame_Stats result = scheduler->stats;
+    return result;
+}
+
+
+#define TETRIS_FRAME_H
+#endif
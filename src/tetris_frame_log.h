@@ -0,0 +1,209 @@
+#if !defined(TETRIS_FRAME_LOG_H)
+
+// @note Frame time recording. The frame loop records every frame into a ring buffer of the most recent
+//       frames and into per session histograms, summaries and exports are made from those on demand.
+//       The export functions need stdio.h, which the platform layer includes before tetris.cpp.
+
+
+#define FRAME_LOG_SIZE 4096 // @note power of two
+#define FRAME_HISTOGRAM_BUCKET_MS 0.1f
+#define FRAME_HISTOGRAM_BUCKET_COUNT 1000 // @note up to 100ms, slower frames land in the last bucket
+
+struct Frame_Log_Entry {
+    f32 work_ms;
+    f32 frame_ms;
+    f32 latency_ms; // @note from polling the input to presenting the frame it went into
+    u64 cycles;
+};
+
+struct Frame_Time_Histogram {
+    u32 buckets[FRAME_HISTOGRAM_BUCKET_COUNT];
+    u64 count;
+    f64 sum;
+    f32 max;
+};
+
+// @note Single producer ring buffer. Entries are written before write_count is published, a reader on another
+//       thread uses copy_frame_log, which drops entries the producer may have overwritten during the copy.
+//       The histograms are only touched by the producer.
+struct Frame_Log {
+    Frame_Log_Entry entries[FRAME_LOG_SIZE];
+    volatile u64 write_count;
+    
+    Frame_Time_Histogram work_ms;
+    Frame_Time_Histogram frame_ms;
+    Frame_Time_Histogram latency_ms;
+    u64 total_cycles;
+    u64 max_cycles;
+};
+
+struct Frame_Time_Summary {
+    f32 p50;
+    f32 p95;
+    f32 p99;
+    f32 max;
+    f32 mean;
+};
+
+struct Frame_Log_Summary {
+    u64 frame_count;
+    Frame_Time_Summary work_ms;
+    Frame_Time_Summary frame_ms;
+    Frame_Time_Summary latency_ms;
+    f64 mean_fps;
+    f64 mean_mcycles;
+    f64 max_mcycles;
+};
+
+internal void
+add_frame_time(Frame_Time_Histogram *histogram, f32 ms) {
+    int bucket = (ms > 0.0f) ? (int)(ms / FRAME_HISTOGRAM_BUCKET_MS) : 0;
+    if (bucket >= FRAME_HISTOGRAM_BUCKET_COUNT)  bucket = FRAME_HISTOGRAM_BUCKET_COUNT - 1;
+    ++histogram->buckets[bucket];
+    ++histogram->count;
+    histogram->sum += ms;
+    if (ms > histogram->max)  histogram->max = ms;
+}
+
+// @note upper edge of the bucket the percentile falls into, so never better than the real value
+internal f32
+get_histogram_percentile(Frame_Time_Histogram *histogram, f32 percentile) {
+    if (histogram->count == 0)  return 0.0f;
+    u64 rank = (u64)((f64)histogram->count * (f64)percentile / 100.0);
+    if (rank >= histogram->count)  rank = histogram->count - 1;
+    
+    u64 seen = 0;
+    for (int bucket = 0; bucket < FRAME_HISTOGRAM_BUCKET_COUNT; ++bucket) {
+        seen += histogram->buckets[bucket];
+        if (seen > rank) {
+            f32 result = (f32)(bucket + 1) * FRAME_HISTOGRAM_BUCKET_MS;
+            if (result > histogram->max || bucket == FRAME_HISTOGRAM_BUCKET_COUNT - 1)  result = histogram->max;
+            return result;
+        }
+    }
+    return histogram->max;
+}
+
+internal Frame_Time_Summary
+summarize_histogram(Frame_Time_Histogram *histogram) {
+    Frame_Time_Summary result = {};
+    result.p50 = get_histogram_percentile(histogram, 50.0f);
+    result.p95 = get_histogram_percentile(histogram, 95.0f);
+    result.p99 = get_histogram_percentile(histogram, 99.0f);
+    result.max = histogram->max;
+    result.mean = (histogram->count > 0) ? (f32)(histogram->sum / (f64)histogram->count) : 0.0f;
+    return result;
+}
+
+inline void
+record_frame_time(Frame_Log *log, f32 work_ms, f32 frame_ms, f32 latency_ms, u64 cycles) {
+    u64 write_count = log->write_count;
+    Frame_Log_Entry *entry = &log->entries[write_count & (FRAME_LOG_SIZE - 1)];
+    entry->work_ms = work_ms;
+    entry->frame_ms = frame_ms;
+    entry->latency_ms = latency_ms;
+    entry->cycles = cycles;
+    atomic_store_release_u64(&log->write_count, write_count + 1);
+    
+    add_frame_time(&log->work_ms, work_ms);
+    add_frame_time(&log->frame_ms, frame_ms);
+    add_frame_time(&log->latency_ms, latency_ms);
+    log->total_cycles += cycles;
+    if (cycles > log->max_cycles)  log->max_cycles = cycles;
+}
+
+// @note copies the most recent frames oldest first, returns the count and the session frame index of the first one
+internal u32
+copy_frame_log(Frame_Log *log, Frame_Log_Entry *dest, u32 max_count, u64 *first_frame_index) {
+    u64 end = atomic_load_acquire_u64(&log->write_count);
+    u64 count = (end < FRAME_LOG_SIZE) ? end : FRAME_LOG_SIZE;
+    if (count > max_count)  count = max_count;
+    u64 start = end - count;
+    for (u64 frame = start; frame < end; ++frame) {
+        dest[frame - start] = log->entries[frame & (FRAME_LOG_SIZE - 1)];
+    }
+    
+    // @note anything the producer lapped while we copied is garbage
+    u64 end_after_copy = atomic_load_acquire_u64(&log->write_count);
+    u64 first_valid = (end_after_copy > FRAME_LOG_SIZE) ? end_after_copy - FRAME_LOG_SIZE : 0;
+    u32 skip = 0;
+    if (first_valid > start) {
+        skip = (u32)((first_valid - start < count) ? first_valid - start : count);
+        memmove(dest, dest + skip, (size_t)(count - skip) * sizeof(Frame_Log_Entry));
+    }
+    
+    *first_frame_index = start + skip;
+    u32 result = (u32)(count - skip);
+    return result;
+}
+
+internal Frame_Log_Summary
+summarize_frame_log(Frame_Log *log) {
+    Frame_Log_Summary result = {};
+    result.frame_count = log->frame_ms.count;
+    result.work_ms = summarize_histogram(&log->work_ms);
+    result.frame_ms = summarize_histogram(&log->frame_ms);
+    result.latency_ms = summarize_histogram(&log->latency_ms);
+    if (result.frame_ms.mean > 0.0f)  result.mean_fps = 1000.0 / (f64)result.frame_ms.mean;
+    if (result.frame_count > 0)  result.mean_mcycles = ((f64)log->total_cycles / (f64)result.frame_count) / 1000000.0;
+    result.max_mcycles = (f64)log->max_cycles / 1000000.0;
+    return result;
+}
+
+// @note one row per frame of the most recent FRAME_LOG_SIZE frames, for plotting
+internal b32
+write_frame_log_csv(Frame_Log *log, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file)  return false;
+    
+    local_persist Frame_Log_Entry entries[FRAME_LOG_SIZE];
+    u64 first_frame_index;
+    u32 count = copy_frame_log(log, entries, FRAME_LOG_SIZE, &first_frame_index);
+    fprintf(file, "frame,work_ms,frame_ms,latency_ms,cycles\n");
+    for (u32 i = 0; i < count; ++i) {
+        fprintf(file, "%llu,%.4f,%.4f,%.4f,%llu\n", (unsigned long long)(first_frame_index + i),
+                entries[i].work_ms, entries[i].frame_ms, entries[i].latency_ms, (unsigned long long)entries[i].cycles);
+    }
+    b32 result = (fclose(file) == 0);
+    return result;
+}
+
+internal void
+write_frame_time_summary_json(FILE *file, const char *name, Frame_Time_Summary *summary, b32 is_last) {
+    fprintf(file, "  \"%s\": { \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"mean\": %.4f }%s\n",
+            name, summary->p50, summary->p95, summary->p99, summary->max, summary->mean, is_last ? "" : ",");
+}
+
+// @note session summary plus the frame time histogram, for comparing builds and machines
+internal b32
+write_frame_log_json(Frame_Log *log, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file)  return false;
+    
+    Frame_Log_Summary summary = summarize_frame_log(log);
+    fprintf(file, "{\n");
+    fprintf(file, "  \"frame_count\": %llu,\n", (unsigned long long)summary.frame_count);
+    fprintf(file, "  \"mean_fps\": %.3f,\n", summary.mean_fps);
+    fprintf(file, "  \"mean_mcycles\": %.4f,\n", summary.mean_mcycles);
+    fprintf(file, "  \"max_mcycles\": %.4f,\n", summary.max_mcycles);
+    write_frame_time_summary_json(file, "work_ms", &summary.work_ms, false);
+    write_frame_time_summary_json(file, "frame_ms", &summary.frame_ms, false);
+    write_frame_time_summary_json(file, "latency_ms", &summary.latency_ms, false);
+    
+    // @note sparse, only buckets with frames in them
+    fprintf(file, "  \"frame_ms_histogram\": { \"bucket_ms\": %.2f, \"buckets\": [", FRAME_HISTOGRAM_BUCKET_MS);
+    b32 is_first = true;
+    for (int bucket = 0; bucket < FRAME_HISTOGRAM_BUCKET_COUNT; ++bucket) {
+        if (!log->frame_ms.buckets[bucket])  continue;
+        fprintf(file, "%s[%d, %u]", is_first ? "" : ", ", bucket, log->frame_ms.buckets[bucket]);
+        is_first = false;
+    }
+    fprintf(file, "] }\n");
+    fprintf(file, "}\n");
+    b32 result = (fclose(file) == 0);
+    return result;
+}
+
+
+#define TETRIS_FRAME_LOG_H
+#endif
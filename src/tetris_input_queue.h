@@ -0,0 +1,132 @@
+#if !defined(TETRIS_INPUT_QUEUE_H)
+
+// @note Button transitions from an input thread to the simulation. The producer, e.g. a thread polling the
+//       devices, pushes every change of a button with the time it happened on the platform's seconds clock
+//       (PLATFORM_GET_SECONDS_SIG). The consumer takes the events that are due by each tick's time (see
+//       get_tick_seconds), so a press goes to the tick it happened before, not to the first tick of the next frame.
+//       Lock free for exactly one producer and one consumer thread. Each side only writes its own counter and
+//       never waits for the other, a full queue drops the new event and counts it.
+
+
+#define INPUT_QUEUE_SIZE 1024 // @note power of two
+#define INPUT_QUEUE_CACHE_LINE_SIZE 64
+
+#define INPUT_EVENT_CONNECTION 0xFF // @note button_index of a controller connecting or disconnecting, is_down is is_connected
+
+struct Input_Event {
+    f64 seconds;
+    u8 controller_index; // @note into Game_Input::controllers
+    u8 button_index;     // @note into Game_Controller_Input::buttons, or INPUT_EVENT_CONNECTION
+    u8 is_down;
+    u8 reserved[5];
+};
+
+// @note The counters only grow, the slot is the count modulo INPUT_QUEUE_SIZE. Each side caches the other's
+//       counter and only reloads it when the queue looks full or empty, so the cache lines are not passed back
+//       and forth on every event.
+struct Input_Queue {
+    alignas(INPUT_QUEUE_CACHE_LINE_SIZE) volatile u64 write_count; // @note producer
+    u64 cached_read_count;
+    volatile u64 dropped_count;
+    
+    alignas(INPUT_QUEUE_CACHE_LINE_SIZE) volatile u64 read_count; // @note consumer
+    u64 cached_write_count;
+    
+    alignas(INPUT_QUEUE_CACHE_LINE_SIZE) Input_Event events[INPUT_QUEUE_SIZE];
+};
+
+// @note the consumer's side, every button as the events taken so far left it
+struct Input_Tracker {
+    Game_Input held;
+    u64 taken_count;
+    f64 taken_seconds_sum; // @note of the taken events' timestamps, for their mean latency
+};
+
+// @note a button's index in Game_Controller_Input::buttons by name, e.g. get_button_index(move_left)
+#define get_button_index(name) ((u32)((offsetof(Game_Controller_Input, name) - offsetof(Game_Controller_Input, buttons)) / sizeof(Game_Button_State)))
+
+inline Input_Event
+make_input_event(f64 seconds, u32 controller_index, u32 button_index, b32 is_down) {
+    Input_Event result = {};
+    result.seconds = seconds;
+    result.controller_index = (u8)controller_index;
+    result.button_index = (u8)button_index;
+    result.is_down = is_down ? 1 : 0;
+    return result;
+}
+
+// @note producer only, false if the queue is full and the event was dropped
+internal b32
+push_input_event(Input_Queue *queue, Input_Event *event) {
+    u64 write_count = queue->write_count;
+    if (write_count - queue->cached_read_count >= INPUT_QUEUE_SIZE) {
+        queue->cached_read_count = atomic_load_acquire_u64(&queue->read_count);
+        if (write_count - queue->cached_read_count >= INPUT_QUEUE_SIZE) {
+            atomic_store_release_u64(&queue->dropped_count, queue->dropped_count + 1);
+            return false;
+        }
+    }
+    queue->events[write_count & (INPUT_QUEUE_SIZE - 1)] = *event;
+    atomic_store_release_u64(&queue->write_count, write_count + 1);
+    return true;
+}
+
+// @note consumer only, copies the oldest event without taking it, false if there is none
+internal b32
+peek_input_event(Input_Queue *queue, Input_Event *event) {
+    u64 read_count = queue->read_count;
+    if (read_count == queue->cached_write_count) {
+        queue->cached_write_count = atomic_load_acquire_u64(&queue->write_count);
+        if (read_count == queue->cached_write_count)  return false;
+    }
+    *event = queue->events[read_count & (INPUT_QUEUE_SIZE - 1)];
+    return true;
+}
+
+// @note consumer only, after peek_input_event returned true, the producer can reuse the slot from here on
+inline void
+pop_input_event(Input_Queue *queue) {
+    atomic_store_release_u64(&queue->read_count, queue->read_count + 1);
+}
+
+// @note Takes every event up to until_seconds and fills tick_input for a tick happening then. A button is down
+//       for the tick if it was pressed since the last tick, so a tap shorter than a tick is not lost and a held
+//       button does not repeat, half_transition_count has the transitions. tracker->held has what is held down
+//       now, for buttons that act while held. Later events stay queued for later ticks. Returns the events taken.
+internal u32
+take_input_events(Input_Queue *queue, Input_Tracker *tracker, f64 until_seconds, Game_Input *tick_input) {
+    *tick_input = {};
+    u32 result = 0;
+    Input_Event event;
+    while (peek_input_event(queue, &event) && event.seconds <= until_seconds) {
+        pop_input_event(queue);
+        ++result;
+        tracker->taken_seconds_sum += event.seconds;
+        if (event.controller_index >= array_count(tracker->held.controllers))  continue;
+        
+        Game_Controller_Input *held = &tracker->held.controllers[event.controller_index];
+        if (event.button_index == INPUT_EVENT_CONNECTION) {
+            held->is_connected = (event.is_down != 0);
+            continue;
+        }
+        if (event.button_index >= array_count(held->buttons))  continue;
+        
+        b32 is_down = (event.is_down != 0);
+        Game_Button_State *held_button = &held->buttons[event.button_index];
+        if (held_button->ended_down == is_down)  continue;
+        held_button->ended_down = is_down;
+        
+        Game_Button_State *tick_button = &tick_input->controllers[event.controller_index].buttons[event.button_index];
+        ++tick_button->half_transition_count;
+        if (is_down)  tick_button->ended_down = true;
+    }
+    for (int controller_index = 0; controller_index < (int)array_count(tick_input->controllers); ++controller_index) {
+        tick_input->controllers[controller_index].is_connected = tracker->held.controllers[controller_index].is_connected;
+    }
+    tracker->taken_count += result;
+    return result;
+}
+
+
+#define TETRIS_INPUT_QUEUE_H
+#endif
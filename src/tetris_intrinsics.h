@@ -0,0 +1,177 @@
+#if !defined(TETRIS_INTRINSICS_H)
+
+// @note Compiler and cpu specific helpers. The system headers are included at the top of tetris.h,
+//       they have to come before iml_types.h.
+
+
+#if TETRIS_X86
+
+#if defined(_MSC_VER)
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+struct Cpu_Features {
+    b32 sse2;
+    b32 avx2;
+};
+
+internal Cpu_Features
+get_cpu_features() {
+    Cpu_Features result = {};
+    result.sse2 = true; // @note x64 baseline
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    b32 os_uses_xsave = (info[2] & (1 << 27)) != 0;
+    b32 has_avx = (info[2] & (1 << 28)) != 0;
+    if (os_uses_xsave && has_avx) {
+        // @note the os has to save the ymm registers on context switches
+        b32 ymm_enabled = ((_xgetbv(0) & 6) == 6);
+        __cpuidex(info, 7, 0);
+        result.avx2 = ymm_enabled && ((info[1] & (1 << 5)) != 0);
+    }
+#else
+    __builtin_cpu_init();
+    result.avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return result;
+}
+
+#else
+
+struct Cpu_Features {
+    b32 sse2;
+    b32 avx2;
+};
+
+internal Cpu_Features
+get_cpu_features() {
+    Cpu_Features result = {};
+    return result;
+}
+
+#endif
+
+
+//
+// @note bit scans, find_least_significant_set_bit needs a value that is not 0
+//
+
+inline u32
+find_least_significant_set_bit(u32 value) {
+    assert(value != 0);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    u32 result = (u32)index;
+#else
+    u32 result = (u32)__builtin_ctz(value);
+#endif
+    return result;
+}
+
+
+// @note without -mpopcnt gcc and clang turn __builtin_popcount into a library call, the bit trick is inlined instead
+inline u32
+count_set_bits(u32 value) {
+#if defined(_MSC_VER)
+    u32 result = (u32)__popcnt(value);
+#elif defined(__POPCNT__) || !TETRIS_X86
+    u32 result = (u32)__builtin_popcount(value);
+#else
+    value = value - ((value >> 1) & 0x55555555);
+    value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+    value = (value + (value >> 4)) & 0x0F0F0F0F;
+    u32 result = (value * 0x01010101) >> 24;
+#endif
+    return result;
+}
+
+
+//
+// @note atomics, release stores pair with acquire loads, for single producer buffers
+//
+
+#if defined(_MSC_VER)
+inline void
+atomic_store_release_u64(volatile u64 *dest, u64 value) {
+    _WriteBarrier();
+    *dest = value; // @note aligned 64 bit stores are atomic on x64
+}
+
+inline u64
+atomic_load_acquire_u64(volatile u64 *source) {
+    u64 result = *source;
+    _ReadBarrier();
+    return result;
+}
+
+// @note both return the previous value
+inline u64
+atomic_add_u64(volatile u64 *dest, u64 value) {
+    u64 result = (u64)_InterlockedExchangeAdd64((volatile __int64 *)dest, (__int64)value);
+    return result;
+}
+
+inline u64
+atomic_exchange_u64(volatile u64 *dest, u64 value) {
+    u64 result = (u64)_InterlockedExchange64((volatile __int64 *)dest, (__int64)value);
+    return result;
+}
+
+inline u32
+atomic_exchange_u32(volatile u32 *dest, u32 value) {
+    u32 result = (u32)_InterlockedExchange((volatile long *)dest, (long)value);
+    return result;
+}
+
+// @note stores value if dest is expected, returns the previous value either way
+inline u64
+atomic_compare_exchange_u64(volatile u64 *dest, u64 expected, u64 value) {
+    u64 result = (u64)_InterlockedCompareExchange64((volatile __int64 *)dest, (__int64)value, (__int64)expected);
+    return result;
+}
+#else
+inline void
+atomic_store_release_u64(volatile u64 *dest, u64 value) {
+    __atomic_store_n(dest, value, __ATOMIC_RELEASE);
+}
+
+inline u64
+atomic_load_acquire_u64(volatile u64 *source) {
+    u64 result = __atomic_load_n(source, __ATOMIC_ACQUIRE);
+    return result;
+}
+
+// @note both return the previous value
+inline u64
+atomic_add_u64(volatile u64 *dest, u64 value) {
+    u64 result = __atomic_fetch_add(dest, value, __ATOMIC_RELAXED);
+    return result;
+}
+
+inline u64
+atomic_exchange_u64(volatile u64 *dest, u64 value) {
+    u64 result = __atomic_exchange_n(dest, value, __ATOMIC_ACQ_REL);
+    return result;
+}
+
+inline u32
+atomic_exchange_u32(volatile u32 *dest, u32 value) {
+    u32 result = __atomic_exchange_n(dest, value, __ATOMIC_ACQ_REL);
+    return result;
+}
+
+// @note stores value if dest is expected, returns the previous value either way
+inline u64
+atomic_compare_exchange_u64(volatile u64 *dest, u64 expected, u64 value) {
+    __atomic_compare_exchange_n(dest, &expected, value, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    return expected;
+}
+#endif
+
+
+#define TETRIS_INTRINSICS_H
+#endif
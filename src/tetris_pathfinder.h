@@ -0,0 +1,276 @@
+#if !defined(TETRIS_PATHFINDER_H)
+
+// @note Reachability search. A breadth first search over (x, y, rotation) from where a piece starts, the
+//       edges are the real inputs: try_move_block left, right and down (soft drop) and rotate_block with its
+//       kicks. Every input costs one press, so the first time a resting spot is found is over a shortest
+//       input sequence. That includes tucks under overhangs and kicked spins, which enumerate_placements can
+//       not see. Gravity is not part of the search, inputs are assumed to come faster than the piece falls.
+//       Results are memoized per (board hash, piece, start), a bot driving many boards reuses them.
+//       Needs tetris_placement.cpp.
+
+
+// @note origins reach up to 3 cells past the left and top grid edge, e.g. the vertical I piece at column 0
+#define PATH_ORIGIN_OFFSET 3
+#define PATH_COLUMN_COUNT (GRID_WIDTH + PATH_ORIGIN_OFFSET)
+#define PATH_ROW_COUNT (GRID_HEIGHT + PATH_ORIGIN_OFFSET)
+#define PATH_STATE_COUNT (4 * PATH_ROW_COUNT * PATH_COLUMN_COUNT)
+
+#define MAX_PATH_INPUTS 64 // @note longer paths are dropped, in practice they are far shorter
+#define MAX_REACHABLE_SPOTS 128
+#define PATH_CACHE_SIZE 64 // @note power of two, direct mapped
+
+enum Path_Input {
+    PATH_INPUT_LEFT,
+    PATH_INPUT_RIGHT,
+    PATH_INPUT_DOWN,
+    PATH_INPUT_ROTATE_CLOCKWISE,
+    PATH_INPUT_ROTATE_COUNTER_CLOCKWISE,
+    
+    PATH_INPUT_COUNT,
+};
+
+struct Reachable_Spot {
+    Block block; // @note resting position
+    u32 input_count;
+    u8 inputs[MAX_PATH_INPUTS]; // @note Path_Input
+};
+
+// @note spots with the same resting cells are listed once with the shortest sequence, shortest first
+struct Reachable_Set {
+    u64 key;
+    b32 is_valid;
+    int count;
+    Reachable_Spot spots[MAX_REACHABLE_SPOTS];
+};
+
+struct Pathfinder {
+    Zobrist_Keys zobrist;
+    Game_State scratch_state; // @note only its rows are used by the move functions
+    
+    // @note search state, visited_stamps avoids clearing the arrays for every search
+    u32 search_stamp;
+    u32 visited_stamps[PATH_STATE_COUNT];
+    u16 parents[PATH_STATE_COUNT];
+    u8 parent_inputs[PATH_STATE_COUNT];
+    u8 distances[PATH_STATE_COUNT];
+    u16 queue[PATH_STATE_COUNT];
+    
+    Reachable_Set cache[PATH_CACHE_SIZE];
+    u64 hit_count;
+    u64 miss_count;
+};
+
+internal void
+init_pathfinder(Pathfinder *pathfinder) {
+    memset(pathfinder, 0, sizeof(*pathfinder));
+    init_zobrist_keys(&pathfinder->zobrist);
+}
+
+inline u32
+get_path_state_index(Block *block) {
+    assert(block->origin.x + PATH_ORIGIN_OFFSET >= 0 && block->origin.x < GRID_WIDTH);
+    assert(block->origin.y + PATH_ORIGIN_OFFSET >= 0 && block->origin.y < GRID_HEIGHT);
+    u32 result = ((block->rotation * PATH_ROW_COUNT + (u32)(block->origin.y + PATH_ORIGIN_OFFSET)) * PATH_COLUMN_COUNT +
+                  (u32)(block->origin.x + PATH_ORIGIN_OFFSET));
+    return result;
+}
+
+inline Block
+get_path_state_block(enum32(Block_Type) type, u32 state_index) {
+    Block result = {};
+    result.type = type;
+    int x = (int)(state_index % PATH_COLUMN_COUNT) - PATH_ORIGIN_OFFSET;
+    int y = (int)((state_index / PATH_COLUMN_COUNT) % PATH_ROW_COUNT) - PATH_ORIGIN_OFFSET;
+    u32 rotation = state_index / (PATH_COLUMN_COUNT * PATH_ROW_COUNT);
+    set_block_placement(&result, x, y, rotation);
+    return result;
+}
+
+// @note applies one input with the same functions game_step uses, returns false if the block did not move
+internal b32
+apply_path_input(Game_State *game_state, Block *block, u32 input) {
+    b32 result = false;
+    switch (input) {
+        case PATH_INPUT_LEFT:  result = try_move_block(game_state, block, -1, 0); break;
+        case PATH_INPUT_RIGHT: result = try_move_block(game_state, block, 1, 0); break;
+        case PATH_INPUT_DOWN:  result = try_move_block(game_state, block, 0, 1); break;
+        case PATH_INPUT_ROTATE_CLOCKWISE:         result = rotate_block(game_state, block, true); break;
+        case PATH_INPUT_ROTATE_COUNTER_CLOCKWISE: result = rotate_block(game_state, block, false); break;
+    }
+    return result;
+}
+
+// @note the buttons game_step reads for an input
+internal void
+set_path_input_button(Game_Controller_Input *controller, u32 input) {
+    switch (input) {
+        case PATH_INPUT_LEFT:  controller->move_left.ended_down = true; break;
+        case PATH_INPUT_RIGHT: controller->move_right.ended_down = true; break;
+        case PATH_INPUT_DOWN:  controller->move_down.ended_down = true; break;
+        case PATH_INPUT_ROTATE_CLOCKWISE:         controller->action_down.ended_down = true; break;
+        case PATH_INPUT_ROTATE_COUNTER_CLOCKWISE: controller->action_right.ended_down = true; break;
+    }
+}
+
+// @note where make_new_current_block puts a new piece
+inline Block
+get_spawn_block(enum32(Block_Type) type) {
+    Block result = {};
+    result.type = type;
+    set_block_placement(&result, SPAWN_X, -piece_orientations[type][0].min_y, 0);
+    return result;
+}
+
+internal void
+search_reachable_spots(Pathfinder *pathfinder, Block *start, Reachable_Set *set) {
+    TIMED_BLOCK("search reachable spots");
+    Game_State *game_state = &pathfinder->scratch_state;
+    enum32(Block_Type) type = start->type;
+    set->count = 0;
+    if (!does_piece_fit(game_state, type, start->rotation, start->origin.x, start->origin.y))  return;
+    
+    ++pathfinder->search_stamp;
+    if (pathfinder->search_stamp == 0) {
+        memset(pathfinder->visited_stamps, 0, sizeof(pathfinder->visited_stamps));
+        pathfinder->search_stamp = 1;
+    }
+    u32 stamp = pathfinder->search_stamp;
+    
+    u32 start_index = get_path_state_index(start);
+    pathfinder->visited_stamps[start_index] = stamp;
+    pathfinder->distances[start_index] = 0;
+    pathfinder->queue[0] = (u16)start_index;
+    u32 queue_read = 0;
+    u32 queue_write = 1;
+    
+    u64 keys[MAX_REACHABLE_SPOTS];
+    while (queue_read < queue_write) {
+        u32 state_index = pathfinder->queue[queue_read++];
+        Block block = get_path_state_block(type, state_index);
+        u32 distance = pathfinder->distances[state_index];
+        
+        for (u32 input = 0; input < PATH_INPUT_COUNT; ++input) {
+            Block moved = block;
+            if (!apply_path_input(game_state, &moved, input)) {
+                if (input != PATH_INPUT_DOWN)  continue;
+                
+                // @note can not move down, a resting spot, reached for the first time over a shortest path
+                if (distance > MAX_PATH_INPUTS || set->count == MAX_REACHABLE_SPOTS)  continue;
+                u64 key = get_cells_key(type, block.rotation, block.origin.x, block.origin.y);
+                b32 is_duplicate = false;
+                for (int i = 0; i < set->count; ++i) {
+                    if (keys[i] == key) {
+                        is_duplicate = true;
+                        break;
+                    }
+                }
+                if (is_duplicate)  continue;
+                
+                keys[set->count] = key;
+                Reachable_Spot *spot = &set->spots[set->count++];
+                spot->block = block;
+                spot->input_count = distance;
+                u32 at = state_index;
+                for (u32 i = distance; i > 0; --i) {
+                    spot->inputs[i - 1] = pathfinder->parent_inputs[at];
+                    at = pathfinder->parents[at];
+                }
+                continue;
+            }
+            
+            u32 moved_index = get_path_state_index(&moved);
+            if (pathfinder->visited_stamps[moved_index] == stamp)  continue;
+            pathfinder->visited_stamps[moved_index] = stamp;
+            pathfinder->parents[moved_index] = (u16)state_index;
+            pathfinder->parent_inputs[moved_index] = (u8)input;
+            pathfinder->distances[moved_index] = (u8)((distance < 255) ? distance + 1 : 255);
+            pathfinder->queue[queue_write++] = (u16)moved_index;
+        }
+    }
+}
+
+// @note Every resting spot a piece can reach from start on the board, start usually being get_spawn_block.
+//       The returned set lives in the cache and stays valid until the next call.
+internal Reachable_Set *
+find_reachable_spots(Pathfinder *pathfinder, u16 *rows, Block *start) {
+    u64 key = (get_zobrist_hash(&pathfinder->zobrist, rows) ^ pathfinder->zobrist.piece_keys[start->type] ^
+               ((u64)(get_path_state_index(start) + 1) * 0x9E3779B97F4A7C15ULL));
+    Reachable_Set *set = &pathfinder->cache[key & (PATH_CACHE_SIZE - 1)];
+    if (set->is_valid && set->key == key) {
+        ++pathfinder->hit_count;
+        return set;
+    }
+    
+    ++pathfinder->miss_count;
+    memcpy(pathfinder->scratch_state.rows, rows, sizeof(pathfinder->scratch_state.rows));
+    search_reachable_spots(pathfinder, start, set);
+    set->key = key;
+    set->is_valid = true;
+    return set;
+}
+
+// @note the spot that rests on the same cells as block, 0 if it can not be reached
+internal Reachable_Spot *
+find_reachable_spot(Reachable_Set *set, Block *block) {
+    u64 key = get_cells_key(block->type, block->rotation, block->origin.x, block->origin.y);
+    for (int i = 0; i < set->count; ++i) {
+        Reachable_Spot *spot = &set->spots[i];
+        if (get_cells_key(spot->block.type, spot->block.rotation, spot->block.origin.x, spot->block.origin.y) == key)  return spot;
+    }
+    return 0;
+}
+
+// @note Same search with a plain list of visited blocks and one iterative deepening pass per distance, only used
+//       to cross check search_reachable_spots (see linux_tetris_headless --verify).
+internal void
+search_reachable_spots_reference(Game_State *game_state, Block *start, Reachable_Set *set) {
+    set->count = 0;
+    if (is_block_out_of_bounds(start) || is_block_colliding(game_state, start))  return;
+    
+    local_persist Block visited[PATH_STATE_COUNT];
+    local_persist u32 visited_distances[PATH_STATE_COUNT];
+    u32 visited_count = 0;
+    visited[visited_count] = *start;
+    visited_distances[visited_count++] = 0;
+    
+    // @note one layer per distance, a block is new if no visited block has the same origin and rotation
+    for (u32 distance = 0;; ++distance) {
+        u32 layer_end = visited_count;
+        b32 added = false;
+        for (u32 i = 0; i < layer_end; ++i) {
+            if (visited_distances[i] != distance)  continue;
+            for (u32 input = 0; input < PATH_INPUT_COUNT; ++input) {
+                Block moved = visited[i];
+                if (!apply_path_input(game_state, &moved, input))  continue;
+                b32 seen = false;
+                for (u32 j = 0; j < visited_count; ++j) {
+                    if (visited[j].rotation == moved.rotation && visited[j].origin.x == moved.origin.x &&
+                        visited[j].origin.y == moved.origin.y) {
+                        seen = true;
+                        break;
+                    }
+                }
+                if (seen)  continue;
+                visited[visited_count] = moved;
+                visited_distances[visited_count++] = distance + 1;
+                added = true;
+            }
+        }
+        if (!added)  break;
+    }
+    
+    // @note resting blocks by distance, the first one per set of cells wins
+    for (u32 i = 0; i < visited_count; ++i) {
+        Block below = visited[i];
+        if (apply_path_input(game_state, &below, PATH_INPUT_DOWN))  continue;
+        if (visited_distances[i] > MAX_PATH_INPUTS || set->count == MAX_REACHABLE_SPOTS)  continue;
+        if (find_reachable_spot(set, &visited[i]))  continue;
+        Reachable_Spot *spot = &set->spots[set->count++];
+        spot->block = visited[i];
+        spot->input_count = visited_distances[i];
+    }
+}
+
+
+#define TETRIS_PATHFINDER_H
+#endif
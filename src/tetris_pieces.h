@@ -0,0 +1,161 @@
+#if !defined(TETRIS_PIECES_H)
+
+// @note Compile time orientation and wall kick tables, following the Super Rotation System (SRS):
+//       https://tetris.wiki/Super_Rotation_System
+//       All coordinates are relative to the top left of the piece's bounding box, y points down.
+
+
+struct Piece_Orientation {
+    Vector2 minos[4];
+    int min_x;
+    int max_x;
+    int min_y;
+    int max_y;
+    u16 row_masks[4]; // @note row r covers min_y + r, bit 0 is column min_x
+    int column_bottoms[4]; // @note column min_x + c, y of the lowest mino, for dropping against column heights
+};
+
+internal constexpr Piece_Orientation
+make_piece_orientation(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
+    Piece_Orientation result = {};
+    result.minos[0] = {x0, y0};
+    result.minos[1] = {x1, y1};
+    result.minos[2] = {x2, y2};
+    result.minos[3] = {x3, y3};
+    
+    result.min_x = x0; result.max_x = x0;
+    result.min_y = y0; result.max_y = y0;
+    for (int i = 1; i < 4; ++i) {
+        if (result.minos[i].x < result.min_x)  result.min_x = result.minos[i].x;
+        if (result.minos[i].x > result.max_x)  result.max_x = result.minos[i].x;
+        if (result.minos[i].y < result.min_y)  result.min_y = result.minos[i].y;
+        if (result.minos[i].y > result.max_y)  result.max_y = result.minos[i].y;
+    }
+    for (int i = 0; i < 4; ++i) {
+        result.row_masks[result.minos[i].y - result.min_y] |= (u16)(1 << (result.minos[i].x - result.min_x));
+    }
+    for (int c = 0; c < 4; ++c) {
+        result.column_bottoms[c] = -1;
+    }
+    for (int i = 0; i < 4; ++i) {
+        int *bottom = &result.column_bottoms[result.minos[i].x - result.min_x];
+        if (result.minos[i].y > *bottom)  *bottom = result.minos[i].y;
+    }
+    
+    return result;
+}
+
+global constexpr Piece_Orientation piece_orientations[Block_Type::ENUM_SIZE][4] = {
+    // Block_Type::EMPTY, unused
+    {},
+    // Block_Type::I
+    {
+        make_piece_orientation(0,1, 1,1, 2,1, 3,1),
+        make_piece_orientation(2,0, 2,1, 2,2, 2,3),
+        make_piece_orientation(0,2, 1,2, 2,2, 3,2),
+        make_piece_orientation(1,0, 1,1, 1,2, 1,3),
+    },
+    // Block_Type::O
+    {
+        make_piece_orientation(1,0, 2,0, 1,1, 2,1),
+        make_piece_orientation(1,0, 2,0, 1,1, 2,1),
+        make_piece_orientation(1,0, 2,0, 1,1, 2,1),
+        make_piece_orientation(1,0, 2,0, 1,1, 2,1),
+    },
+    // Block_Type::T
+    {
+        make_piece_orientation(1,0, 0,1, 1,1, 2,1),
+        make_piece_orientation(1,0, 1,1, 2,1, 1,2),
+        make_piece_orientation(0,1, 1,1, 2,1, 1,2),
+        make_piece_orientation(1,0, 0,1, 1,1, 1,2),
+    },
+    // Block_Type::S
+    {
+        make_piece_orientation(1,0, 2,0, 0,1, 1,1),
+        make_piece_orientation(1,0, 1,1, 2,1, 2,2),
+        make_piece_orientation(1,1, 2,1, 0,2, 1,2),
+        make_piece_orientation(0,0, 0,1, 1,1, 1,2),
+    },
+    // Block_Type::Z
+    {
+        make_piece_orientation(0,0, 1,0, 1,1, 2,1),
+        make_piece_orientation(2,0, 1,1, 2,1, 1,2),
+        make_piece_orientation(0,1, 1,1, 1,2, 2,2),
+        make_piece_orientation(1,0, 0,1, 1,1, 0,2),
+    },
+    // Block_Type::J
+    {
+        make_piece_orientation(0,0, 0,1, 1,1, 2,1),
+        make_piece_orientation(1,0, 2,0, 1,1, 1,2),
+        make_piece_orientation(0,1, 1,1, 2,1, 2,2),
+        make_piece_orientation(1,0, 1,1, 0,2, 1,2),
+    },
+    // Block_Type::L
+    {
+        make_piece_orientation(2,0, 0,1, 1,1, 2,1),
+        make_piece_orientation(1,0, 1,1, 1,2, 2,2),
+        make_piece_orientation(0,1, 1,1, 2,1, 0,2),
+        make_piece_orientation(0,0, 1,0, 1,1, 1,2),
+    },
+};
+
+
+//
+// @note wall kicks
+//
+
+#define KICK_COUNT 5
+
+enum Kick_Set {
+    KICK_SET_O,     // @note the O piece never kicks
+    KICK_SET_JLSTZ,
+    KICK_SET_I,
+    
+    KICK_SET_COUNT,
+};
+
+global constexpr u32 kick_set_by_type[Block_Type::ENUM_SIZE] = {
+    KICK_SET_O,     // Block_Type::EMPTY, unused
+    KICK_SET_I,
+    KICK_SET_O,
+    KICK_SET_JLSTZ,
+    KICK_SET_JLSTZ,
+    KICK_SET_JLSTZ,
+    KICK_SET_JLSTZ,
+    KICK_SET_JLSTZ,
+};
+
+global constexpr int kick_count_by_set[KICK_SET_COUNT] = { 1, KICK_COUNT, KICK_COUNT };
+
+// @note [kick_set][from_rotation][0 = clockwise, 1 = counter clockwise][kick]
+//       The wiki lists the offsets with y pointing up, these are flipped to y pointing down.
+global constexpr Vector2 kick_offsets[KICK_SET_COUNT][4][2][KICK_COUNT] = {
+    // KICK_SET_O
+    {},
+    // KICK_SET_JLSTZ
+    {
+        { { {0,0}, {-1,0}, {-1,-1}, {0, 2}, {-1, 2} },   // 0->R
+          { {0,0}, { 1,0}, { 1,-1}, {0, 2}, { 1, 2} } }, // 0->L
+        { { {0,0}, { 1,0}, { 1, 1}, {0,-2}, { 1,-2} },   // R->2
+          { {0,0}, { 1,0}, { 1, 1}, {0,-2}, { 1,-2} } }, // R->0
+        { { {0,0}, { 1,0}, { 1,-1}, {0, 2}, { 1, 2} },   // 2->L
+          { {0,0}, {-1,0}, {-1,-1}, {0, 2}, {-1, 2} } }, // 2->R
+        { { {0,0}, {-1,0}, {-1, 1}, {0,-2}, {-1,-2} },   // L->0
+          { {0,0}, {-1,0}, {-1, 1}, {0,-2}, {-1,-2} } }, // L->2
+    },
+    // KICK_SET_I
+    {
+        { { {0,0}, {-2,0}, { 1,0}, {-2, 1}, { 1,-2} },   // 0->R
+          { {0,0}, {-1,0}, { 2,0}, {-1,-2}, { 2, 1} } }, // 0->L
+        { { {0,0}, {-1,0}, { 2,0}, {-1,-2}, { 2, 1} },   // R->2
+          { {0,0}, { 2,0}, {-1,0}, { 2,-1}, {-1, 2} } }, // R->0
+        { { {0,0}, { 2,0}, {-1,0}, { 2,-1}, {-1, 2} },   // 2->L
+          { {0,0}, { 1,0}, {-2,0}, { 1, 2}, {-2,-1} } }, // 2->R
+        { { {0,0}, { 1,0}, {-2,0}, { 1, 2}, {-2,-1} },   // L->0
+          { {0,0}, {-2,0}, { 1,0}, {-2, 1}, { 1,-2} } }, // L->2
+    },
+};
+
+
+#define TETRIS_PIECES_H
+#endif
@@ -0,0 +1,237 @@
+#include "tetris_placement.h"
+
+
+// @note same compaction as clear_full_lines on the occupancy only, no color plane and no statistics
+internal int
+clear_full_rows(u16 *rows, int top_y, int bottom_y) {
+    int cleared_count = 0;
+    for (int y = top_y; y <= bottom_y; ++y) {
+        if (rows[y] == FULL_ROW_MASK)  ++cleared_count;
+    }
+    if (cleared_count == 0)  return 0;
+    
+    int write_y = bottom_y;
+    for (int y = bottom_y; y >= 0; --y) {
+        if (y >= top_y && rows[y] == FULL_ROW_MASK)  continue;
+        rows[write_y--] = rows[y];
+    }
+    while (write_y >= 0) {
+        rows[write_y--] = 0;
+    }
+    return cleared_count;
+}
+
+// @note The cells of a piece at the given origin packed as 4 rows of GRID_WIDTH bits plus the top row.
+//       Different rotations and origins that cover the same cells get the same key.
+inline u64
+get_cells_key(enum32(Block_Type) type, u32 rotation, int x, int y) {
+    const Piece_Orientation *orientation = &piece_orientations[type][rotation];
+    int left = x + orientation->min_x;
+    int row_count = orientation->max_y - orientation->min_y + 1;
+    u64 result = (u64)(y + orientation->min_y) << (4 * GRID_WIDTH);
+    for (int row = 0; row < row_count; ++row) {
+        result |= (u64)(orientation->row_masks[row] << left) << (row * GRID_WIDTH);
+    }
+    return result;
+}
+
+// @note Fills list with every distinct placement of a piece of the given type on game_state's board and its
+//       caches, the current_block is ignored. The landing board's features are updated from the board's. Returns the count, 0 if the piece can not even spawn.
+internal int
+enumerate_placements(Game_State *game_state, enum32(Block_Type) type, Placement_List *list) {
+    TIMED_BLOCK("enumerate placements");
+    assert(type > Block_Type::EMPTY && type < Block_Type::ENUM_SIZE);
+    list->count = 0;
+    
+    u64 keys[MAX_PLACEMENTS];
+    
+    for (u32 rotation = 0; rotation < 4; ++rotation) {
+        const Piece_Orientation *orientation = &piece_orientations[type][rotation];
+        int start_y = -orientation->min_y;
+        if (!does_piece_fit(game_state, type, rotation, SPAWN_X, start_y))  continue;
+        
+        // @note columns reachable by shifting along the spawn row, stop at the first blocked one
+        int min_x = SPAWN_X;
+        while (does_piece_fit(game_state, type, rotation, min_x - 1, start_y))  --min_x;
+        int max_x = SPAWN_X;
+        while (does_piece_fit(game_state, type, rotation, max_x + 1, start_y))  ++max_x;
+        
+        int row_count = orientation->max_y - orientation->min_y + 1;
+        for (int x = min_x; x <= max_x; ++x) {
+            int y = start_y + get_drop_distance(game_state, type, rotation, x, start_y);
+            int top = y + orientation->min_y;
+            
+            u64 key = get_cells_key(type, rotation, x, y);
+            b32 is_duplicate = false;
+            for (int i = 0; i < list->count; ++i) {
+                if (keys[i] == key) {
+                    is_duplicate = true;
+                    break;
+                }
+            }
+            if (is_duplicate)  continue;
+            
+            keys[list->count] = key;
+            Placement *placement = &list->placements[list->count++];
+            placement->block.type = type;
+            set_block_placement(&placement->block, x, y, rotation);
+            memcpy(placement->rows, game_state->rows, sizeof(placement->rows));
+            int column_tops[GRID_WIDTH];
+            memcpy(column_tops, game_state->column_tops, sizeof(column_tops));
+            placement->features = game_state->features;
+            add_piece_to_board(placement->rows, column_tops, &placement->features, type, rotation, x, y);
+            placement->lines_cleared = clear_full_rows(placement->rows, top, top + row_count - 1);
+            if (placement->lines_cleared) {
+                get_column_tops(placement->rows, column_tops);
+                placement->features = get_board_features(placement->rows, column_tops);
+            }
+#if TETRIS_SLOW
+            get_column_tops(placement->rows, column_tops);
+            Board_Features features = get_board_features(placement->rows, column_tops);
+            assert(memcmp(&features, &placement->features, sizeof(features)) == 0);
+#endif
+        }
+    }
+    return list->count;
+}
+
+// @note locks the placement's block like gravity would, including the line clear and the next spawn
+internal Line_Clear_Result
+lock_placement(Game_State *game_state, Placement *placement) {
+    game_state->current_block = placement->block;
+    Block block = placement->block;
+    Line_Clear_Result result = lock_block_and_spawn_next(game_state, &block);
+    return result;
+}
+
+// @note Block by block reference on is_block_out_of_bounds and is_block_colliding with a full game state per
+//       placement, only used to cross check enumerate_placements (see linux_tetris_headless --verify).
+//       Lists the placements in the same order.
+internal int
+enumerate_placements_reference(Game_State *game_state, enum32(Block_Type) type, Placement_List *list) {
+    list->count = 0;
+    u16 occupancies[MAX_PLACEMENTS][GRID_HEIGHT];
+    
+    for (u32 rotation = 0; rotation < 4; ++rotation) {
+        Block spawn = {};
+        spawn.type = type;
+        set_block_placement(&spawn, SPAWN_X, -piece_orientations[type][rotation].min_y, rotation);
+        if (is_block_out_of_bounds(&spawn) || is_block_colliding(game_state, &spawn))  continue;
+        
+        Block leftmost = spawn;
+        for (;;) {
+            Block moved = leftmost;
+            set_block_placement(&moved, moved.origin.x - 1, moved.origin.y, rotation);
+            if (is_block_out_of_bounds(&moved) || is_block_colliding(game_state, &moved))  break;
+            leftmost = moved;
+        }
+        
+        for (Block block = leftmost;;) {
+            Block dropped = block;
+            for (;;) {
+                Block moved = dropped;
+                set_block_placement(&moved, moved.origin.x, moved.origin.y + 1, rotation);
+                if (is_block_out_of_bounds(&moved) || is_block_colliding(game_state, &moved))  break;
+                dropped = moved;
+            }
+            
+            Game_State landed = *game_state;
+            add_block_to_grid(&landed, &dropped);
+            b32 is_duplicate = false;
+            for (int i = 0; i < list->count; ++i) {
+                if (memcmp(occupancies[i], landed.rows, sizeof(landed.rows)) == 0)  is_duplicate = true;
+            }
+            if (!is_duplicate) {
+                memcpy(occupancies[list->count], landed.rows, sizeof(landed.rows));
+                Placement *placement = &list->placements[list->count++];
+                placement->block = dropped;
+                placement->lines_cleared = clear_full_lines_reference(&landed);
+                for (int y = 0; y < GRID_HEIGHT; ++y) {
+                    placement->rows[y] = 0;
+                    for (int x = 0; x < GRID_WIDTH; ++x) {
+                        if (landed.grid[y][x] != Block_Type::EMPTY)  placement->rows[y] |= (u16)(1 << x);
+                    }
+                }
+            }
+            
+            Block moved = block;
+            set_block_placement(&moved, moved.origin.x + 1, moved.origin.y, rotation);
+            if (is_block_out_of_bounds(&moved) || is_block_colliding(game_state, &moved))  break;
+            block = moved;
+        }
+    }
+    return list->count;
+}
+
+//
+// @note Zobrist hashing
+//
+
+// @note always the same keys, hashes can be compared between runs and between a planner and a pathfinder
+internal void
+init_zobrist_keys(Zobrist_Keys *keys) {
+    Random_Series series = random_seed(0x2F0B1E5ULL);
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            keys->cell_keys[y][x] = ((u64)random_next_u32(&series) << 32) | random_next_u32(&series);
+        }
+    }
+    for (int type = 0; type < Block_Type::ENUM_SIZE; ++type) {
+        keys->piece_keys[type] = ((u64)random_next_u32(&series) << 32) | random_next_u32(&series);
+    }
+}
+
+internal u64
+get_zobrist_hash(Zobrist_Keys *keys, u16 *rows) {
+    u64 result = 0;
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        u32 row = rows[y];
+        while (row) {
+            result ^= keys->cell_keys[y][find_least_significant_set_bit(row)];
+            row &= row - 1;
+        }
+    }
+    return result;
+}
+
+// @note without a line clear only the locked cells change, otherwise the rows moved and everything is hashed again
+inline u64
+get_placement_hash(Zobrist_Keys *keys, u64 board_hash, Placement *placement) {
+    u64 result = board_hash;
+    if (placement->lines_cleared == 0) {
+        for (int i = 0; i < 4; ++i) {
+            result ^= keys->cell_keys[placement->block.pos[i].y][placement->block.pos[i].x];
+        }
+    }
+    else {
+        result = get_zobrist_hash(keys, placement->rows);
+    }
+    return result;
+}
+
+
+//
+// @note board evaluation
+//
+
+// @note Weights from Yiyuan Lee's genetic tuning. The board terms are split from the line reward,
+//       so a search can add up the lines along a path and evaluate only the board it ends on.
+#define EVALUATION_HEIGHT_WEIGHT    -0.510066f
+#define EVALUATION_LINES_WEIGHT      0.760666f
+#define EVALUATION_HOLES_WEIGHT     -0.35663f
+#define EVALUATION_BUMPINESS_WEIGHT -0.184483f
+
+internal f32
+evaluate_board(Board_Features *features) {
+    f32 result = (EVALUATION_HEIGHT_WEIGHT * (f32)features->aggregate_height +
+                  EVALUATION_HOLES_WEIGHT * (f32)features->holes +
+                  EVALUATION_BUMPINESS_WEIGHT * (f32)features->bumpiness);
+    return result;
+}
+
+// @note higher is better, plays for a very long time when picking the best placement every piece
+internal f32
+evaluate_placement(Placement *placement) {
+    f32 result = evaluate_board(&placement->features) + EVALUATION_LINES_WEIGHT * (f32)placement->lines_cleared;
+    return result;
+}
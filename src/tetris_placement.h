@@ -0,0 +1,33 @@
+#if !defined(TETRIS_PLACEMENT_H)
+
+// @note Placement enumeration for automated players. Instead of feeding button presses an agent asks for
+//       every resting position of a piece on the current board, together with the board it leaves behind.
+//       A placement is reached like a player does it at the top of the grid: rotate at the spawn row,
+//       shift left or right until blocked, drop straight down. Tucks and spins under overhangs are not included.
+
+
+// @note at most one placement per rotation and column
+#define MAX_PLACEMENTS (4 * GRID_WIDTH)
+
+struct Placement {
+    Block block;           // @note resting position, ready for add_block_to_grid
+    u16 rows[GRID_HEIGHT]; // @note landing board, occupancy after the lock and the line clear
+    Board_Features features; // @note of the landing board
+    int lines_cleared;
+};
+
+// @note placements with the same resting cells are listed once, e.g. the I piece's two horizontal rotations
+struct Placement_List {
+    int count;
+    Placement placements[MAX_PLACEMENTS];
+};
+
+// @note random keys per cell and piece, a board hashes to the xor of the keys of its occupied cells
+struct Zobrist_Keys {
+    u64 cell_keys[GRID_HEIGHT][GRID_WIDTH];
+    u64 piece_keys[Block_Type::ENUM_SIZE];
+};
+
+
+#define TETRIS_PLACEMENT_H
+#endif
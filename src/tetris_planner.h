@@ -0,0 +1,350 @@
+#if !defined(TETRIS_PLANNER_H)
+
+// @note Lookahead planner and bot. A beam search over the current piece and the preview queue: every layer
+//       expands the placements of the next piece for each board in the beam and keeps the beam_width best.
+//       Boards reached through different placement orders are merged with a Zobrist hash in a transposition
+//       table, which is a fixed array of cache line sized buckets, reused between searches through a
+//       generation counter instead of clearing it.
+//       The bot drives the live game through Game_Controller_Input like a player would, one button per tick.
+//       Needs tetris_placement.cpp, tetris_pathfinder.h and tetris_frame.h for the clock.
+
+
+#define MAX_BEAM_WIDTH 256
+#define MAX_SEARCH_DEPTH (1 + PREVIEW_COUNT) // @note the current piece plus every preview
+#define TRANSPOSITION_BUCKET_COUNT (1 << 14) // @note power of two, 1MB
+#define TRANSPOSITION_BUCKET_SIZE 4
+#define PLANNER_CLOCK_CHECK_INTERVAL 32 // @note beam nodes between checks of the time budget
+
+struct Transposition_Entry {
+    u64 key;
+    u32 generation; // @note only entries of the current generation are valid
+    u32 node_index; // @note candidate with this board in the layer being expanded
+};
+
+struct alignas(64) Transposition_Bucket {
+    Transposition_Entry entries[TRANSPOSITION_BUCKET_SIZE];
+};
+typedef bool __check_transposition_bucket_size__[sizeof(Transposition_Bucket) == 64 ? 1 : -1];
+
+struct Beam_Node {
+    u16 rows[GRID_HEIGHT];
+    u64 hash;       // @note Zobrist hash of rows
+    f32 line_value; // @note line reward summed along the path
+    f32 value;      // @note line_value plus evaluate_board of rows, higher is better
+    u32 root_index; // @note placement of the current piece this node descends from
+};
+
+// @note can be changed between any two searches
+struct Planner_Settings {
+    u32 depth;          // @note pieces to look at, 1 is greedy, clamped to MAX_SEARCH_DEPTH
+    u32 beam_width;     // @note clamped to MAX_BEAM_WIDTH
+    f64 budget_seconds; // @note stops deepening once used up, 0 for no limit
+};
+
+struct Planner_Result {
+    int placement_index; // @note into root_placements, -1 if the current piece can not be placed
+    Placement placement;
+    u32 completed_depth;
+    u32 node_count;      // @note boards expanded over all layers
+    u32 merged_count;    // @note boards dropped as transpositions of a board already in the layer
+    f64 seconds;
+};
+
+struct Planner {
+    Zobrist_Keys zobrist;
+    u32 generation;
+    Transposition_Bucket table[TRANSPOSITION_BUCKET_COUNT];
+    
+    Game_State scratch_state; // @note only its rows and board caches are used, enumerate_placements wants a Game_State
+    Placement_List root_placements;
+    Placement_List placements;
+    Beam_Node beam[MAX_BEAM_WIDTH];
+    Beam_Node candidates[MAX_BEAM_WIDTH * MAX_PLACEMENTS];
+    u32 heap[MAX_BEAM_WIDTH];
+};
+
+// @note the planner is big, the platform layer allocates it once
+internal void
+init_planner(Planner *planner) {
+    init_zobrist_keys(&planner->zobrist);
+    planner->generation = 0;
+    memset(planner->table, 0, sizeof(planner->table));
+}
+
+// @note returns the entry for key, a free entry set to key if it was not there, or 0 if the bucket is full
+internal Transposition_Entry *
+find_transposition(Planner *planner, u64 key, b32 *found) {
+    Transposition_Bucket *bucket = &planner->table[key & (TRANSPOSITION_BUCKET_COUNT - 1)];
+    Transposition_Entry *free_entry = 0;
+    for (int i = 0; i < TRANSPOSITION_BUCKET_SIZE; ++i) {
+        Transposition_Entry *entry = &bucket->entries[i];
+        if (entry->generation != planner->generation) {
+            if (!free_entry)  free_entry = entry;
+        }
+        else if (entry->key == key) {
+            *found = true;
+            return entry;
+        }
+    }
+    *found = false;
+    if (free_entry) {
+        free_entry->key = key;
+        free_entry->generation = planner->generation;
+    }
+    return free_entry;
+}
+
+// @note a new generation invalidates the whole table at once
+internal void
+next_transposition_generation(Planner *planner) {
+    ++planner->generation;
+    if (planner->generation == 0) {
+        memset(planner->table, 0, sizeof(planner->table));
+        planner->generation = 1;
+    }
+}
+
+// @note min heap on value, the root is the worst of the kept candidates
+internal void
+sift_down_beam_heap(Beam_Node *candidates, u32 *heap, u32 count, u32 index) {
+    for (;;) {
+        u32 smallest = index;
+        u32 left = 2 * index + 1;
+        u32 right = left + 1;
+        if (left < count && candidates[heap[left]].value < candidates[heap[smallest]].value)  smallest = left;
+        if (right < count && candidates[heap[right]].value < candidates[heap[smallest]].value)  smallest = right;
+        if (smallest == index)  break;
+        u32 temp = heap[index];
+        heap[index] = heap[smallest];
+        heap[smallest] = temp;
+        index = smallest;
+    }
+}
+
+// @note moves the beam_width best candidates into the beam, returns the new beam count
+internal u32
+select_beam(Planner *planner, u32 candidate_count, u32 beam_width) {
+    u32 *heap = planner->heap;
+    u32 heap_count = 0;
+    for (u32 index = 0; index < candidate_count; ++index) {
+        if (heap_count < beam_width) {
+            heap[heap_count++] = index;
+            if (heap_count == beam_width) {
+                for (u32 i = heap_count / 2; i-- > 0;) {
+                    sift_down_beam_heap(planner->candidates, heap, heap_count, i);
+                }
+            }
+        }
+        else if (planner->candidates[index].value > planner->candidates[heap[0]].value) {
+            heap[0] = index;
+            sift_down_beam_heap(planner->candidates, heap, heap_count, 0);
+        }
+    }
+    for (u32 i = 0; i < heap_count; ++i) {
+        planner->beam[i] = planner->candidates[heap[i]];
+    }
+    return heap_count;
+}
+
+// @note Picks the placement of the game's current piece. Searches layer by layer, a layer that runs out of
+//       budget is thrown away and the best board of the last complete layer decides. The first layer is always
+//       completed, so there is an answer even with a tiny budget.
+internal Planner_Result
+plan_placement(Planner *planner, Game_State *game_state, Planner_Settings *settings,
+               Platform_Get_Seconds_Sig *get_seconds) {
+    TIMED_BLOCK("plan placement");
+    Planner_Result result = {};
+    result.placement_index = -1;
+    f64 start_seconds = get_seconds();
+    
+    u32 depth = settings->depth;
+    if (depth < 1)  depth = 1;
+    if (depth > MAX_SEARCH_DEPTH)  depth = MAX_SEARCH_DEPTH;
+    u32 beam_width = settings->beam_width;
+    if (beam_width < 1)  beam_width = 1;
+    if (beam_width > MAX_BEAM_WIDTH)  beam_width = MAX_BEAM_WIDTH;
+    
+    enum32(Block_Type) pieces[MAX_SEARCH_DEPTH + 1] = {};
+    pieces[0] = game_state->current_block.type;
+    for (u32 i = 1; i < depth; ++i) {
+        pieces[i] = peek_piece(&game_state->piece_generator, i - 1);
+    }
+    
+    Placement_List *root_placements = &planner->root_placements;
+    if (enumerate_placements(game_state, pieces[0], root_placements) == 0)  return result;
+    
+    Beam_Node *root = &planner->beam[0];
+    memcpy(root->rows, game_state->rows, sizeof(root->rows));
+    root->hash = get_zobrist_hash(&planner->zobrist, root->rows);
+    root->line_value = 0;
+    root->value = 0;
+    root->root_index = 0;
+    u32 beam_count = 1;
+    
+    for (u32 layer = 0; layer < depth; ++layer) {
+        next_transposition_generation(planner);
+        b32 out_of_time = false;
+        u32 candidate_count = 0;
+        for (u32 node_index = 0; node_index < beam_count; ++node_index) {
+            Beam_Node *node = &planner->beam[node_index];
+            Placement_List *placements = root_placements;
+            if (layer > 0) {
+                memcpy(planner->scratch_state.rows, node->rows, sizeof(node->rows));
+                rebuild_board_cache(&planner->scratch_state);
+                placements = &planner->placements;
+                enumerate_placements(&planner->scratch_state, pieces[layer], placements);
+            }
+            ++result.node_count;
+            
+            for (int i = 0; i < placements->count; ++i) {
+                Placement *placement = &placements->placements[i];
+                u64 hash = get_placement_hash(&planner->zobrist, node->hash, placement);
+                f32 line_value = node->line_value + EVALUATION_LINES_WEIGHT * (f32)placement->lines_cleared;
+                f32 value = line_value + evaluate_board(&placement->features);
+                
+                // @note the next piece is the same for the whole layer, it still goes into the key so keys never
+                //       match across layers of one search
+                b32 found;
+                Transposition_Entry *entry = find_transposition(planner, hash ^ planner->zobrist.piece_keys[pieces[layer + 1]], &found);
+                Beam_Node *candidate;
+                if (found) {
+                    ++result.merged_count;
+                    candidate = &planner->candidates[entry->node_index];
+                    if (value <= candidate->value)  continue;
+                }
+                else {
+                    if (entry)  entry->node_index = candidate_count;
+                    candidate = &planner->candidates[candidate_count++];
+                }
+                memcpy(candidate->rows, placement->rows, sizeof(candidate->rows));
+                candidate->hash = hash;
+                candidate->line_value = line_value;
+                candidate->value = value;
+                candidate->root_index = (layer == 0) ? (u32)i : node->root_index;
+            }
+            
+            if (layer > 0 && settings->budget_seconds > 0 && (node_index % PLANNER_CLOCK_CHECK_INTERVAL) == 0 &&
+                get_seconds() - start_seconds > settings->budget_seconds) {
+                out_of_time = true;
+                break;
+            }
+        }
+        // @note no board of this layer can take the next piece, the previous layer decides
+        if (out_of_time || candidate_count == 0)  break;
+        
+        beam_count = select_beam(planner, candidate_count, beam_width);
+        result.completed_depth = layer + 1;
+        if (settings->budget_seconds > 0 && get_seconds() - start_seconds > settings->budget_seconds)  break;
+    }
+    
+    Beam_Node *best = &planner->beam[0];
+    for (u32 node_index = 1; node_index < beam_count; ++node_index) {
+        Beam_Node *node = &planner->beam[node_index];
+        if (node->value > best->value || (node->value == best->value && node->root_index < best->root_index))  best = node;
+    }
+    result.placement_index = (int)best->root_index;
+    result.placement = root_placements->placements[best->root_index];
+    result.seconds = get_seconds() - start_seconds;
+    return result;
+}
+
+
+//
+// @note bot
+//
+
+struct Bot {
+    Planner *planner;
+    Pathfinder *pathfinder; // @note optional, without it the bot steers greedily and can not tuck
+    Planner_Settings settings;
+    u64 planned_piece; // @note pieces_spawned of the piece the target was planned for
+    b32 has_target;
+    Block target;
+    Planner_Result last_result;
+    
+    // @note shortest input sequence to the target, path_blocks[i] is where the piece is before input i
+    b32 has_path;
+    u32 path_length;
+    u8 path_inputs[MAX_PATH_INPUTS];
+    Block path_blocks[MAX_PATH_INPUTS + 1];
+};
+
+internal void
+init_bot(Bot *bot, Planner *planner, Pathfinder *pathfinder, Planner_Settings settings) {
+    *bot = {};
+    bot->planner = planner;
+    bot->pathfinder = pathfinder;
+    bot->settings = settings;
+    init_planner(planner);
+    if (pathfinder)  init_pathfinder(pathfinder);
+}
+
+// @note the path from where the current_block is now, false if the target can not be reached from here
+internal b32
+find_bot_path(Bot *bot, Game_State *game_state) {
+    Block *block = &game_state->current_block;
+    Reachable_Set *set = find_reachable_spots(bot->pathfinder, game_state->rows, block);
+    Reachable_Spot *spot = find_reachable_spot(set, &bot->target);
+    if (!spot)  return false;
+    
+    bot->path_length = spot->input_count;
+    bot->path_blocks[0] = *block;
+    for (u32 i = 0; i < spot->input_count; ++i) {
+        bot->path_inputs[i] = spot->inputs[i];
+        bot->path_blocks[i + 1] = bot->path_blocks[i];
+        apply_path_input(game_state, &bot->path_blocks[i + 1], spot->inputs[i]);
+    }
+    return true;
+}
+
+// @note Plans once per piece and presses the next input of the shortest path to the target. If the piece is
+//       not where the path expects it, usually because gravity moved it, the path is searched again from there.
+//       Without a path it steers greedily: rotations first, then the column, then soft drop.
+internal void
+get_bot_input(Bot *bot, Game_State *game_state, Platform_Get_Seconds_Sig *get_seconds, Game_Controller_Input *controller) {
+    *controller = {};
+    controller->is_connected = true;
+    
+    if (!bot->has_target || bot->planned_piece != game_state->pieces_spawned) {
+        bot->last_result = plan_placement(bot->planner, game_state, &bot->settings, get_seconds);
+        bot->planned_piece = game_state->pieces_spawned;
+        bot->has_target = (bot->last_result.placement_index >= 0);
+        bot->has_path = false;
+        if (bot->has_target)  bot->target = bot->last_result.placement.block;
+    }
+    if (!bot->has_target)  return;
+    
+    Block *block = &game_state->current_block;
+    if (bot->pathfinder) {
+        u32 step = bot->path_length + 1;
+        if (bot->has_path) {
+            for (u32 i = 0; i <= bot->path_length; ++i) {
+                if (bot->path_blocks[i].rotation == block->rotation && bot->path_blocks[i].origin.x == block->origin.x &&
+                    bot->path_blocks[i].origin.y == block->origin.y) {
+                    step = i;
+                    break;
+                }
+            }
+        }
+        if (step > bot->path_length) {
+            bot->has_path = find_bot_path(bot, game_state);
+            step = 0;
+        }
+        // @note at the end of the path the piece rests on the target and gravity locks it
+        if (bot->has_path) {
+            if (step < bot->path_length)  set_path_input_button(controller, bot->path_inputs[step]);
+            return;
+        }
+    }
+    
+    u32 rotations = (bot->target.rotation - block->rotation) & 3;
+    if (rotations == 1 || rotations == 2)  controller->action_down.ended_down = true; // @note clockwise
+    else if (rotations == 3)               controller->action_right.ended_down = true;
+    else if (block->origin.x > bot->target.origin.x)  controller->move_left.ended_down = true;
+    else if (block->origin.x < bot->target.origin.x)  controller->move_right.ended_down = true;
+    else                                               controller->move_down.ended_down = true;
+}
+
+
+#define TETRIS_PLANNER_H
+#endif
@@ -0,0 +1,114 @@
+#if !defined(TETRIS_RANDOM_H)
+
+// @note Seedable PCG32 random series (https://www.pcg-random.org) and the 7-bag piece generator.
+//       Everything lives inside Game_State, so identical seeds always give identical piece sequences.
+
+
+struct Random_Series {
+    u64 state;
+    u64 increment;
+};
+
+inline u32
+random_next_u32(Random_Series *series) {
+    u64 old_state = series->state;
+    series->state = old_state * 6364136223846793005ULL + series->increment;
+    u32 xorshifted = (u32)(((old_state >> 18u) ^ old_state) >> 27u);
+    u32 rotation = (u32)(old_state >> 59u);
+    u32 result = (xorshifted >> rotation) | (xorshifted << ((0u - rotation) & 31u));
+    return result;
+}
+
+internal Random_Series
+random_seed(u64 seed, u64 stream = 0x853C49E6748FEA9BULL) {
+    Random_Series series = {};
+    series.increment = (stream << 1u) | 1u;
+    random_next_u32(&series);
+    series.state += seed;
+    random_next_u32(&series);
+    return series;
+}
+
+// @note unbiased number in [0, count), Lemire's multiply and reject
+inline u32
+random_choice(Random_Series *series, u32 count) {
+    u64 product = (u64)random_next_u32(series) * (u64)count;
+    u32 low = (u32)product;
+    if (low < count) {
+        u32 threshold = (0u - count) % count;
+        while (low < threshold) {
+            product = (u64)random_next_u32(series) * (u64)count;
+            low = (u32)product;
+        }
+    }
+    u32 result = (u32)(product >> 32);
+    return result;
+}
+
+
+//
+// @note 7-bag generator with preview queue
+//
+
+#define BAG_SIZE 7 // @note every Block_Type except EMPTY, checked in tetris.h
+#define PREVIEW_COUNT 5
+#define PIECE_QUEUE_SIZE 16 // @note power of two, has to hold PREVIEW_COUNT + 1 pieces plus a full bag
+
+struct Piece_Generator {
+    Random_Series series;
+    u8 queue[PIECE_QUEUE_SIZE]; // @note ring buffer of Block_Type
+    u32 queue_read;
+    u32 queue_count;
+};
+
+internal void
+refill_piece_queue(Piece_Generator *generator) {
+    while (generator->queue_count <= PREVIEW_COUNT) {
+        // @note Fisher-Yates shuffle of one bag with every piece exactly once
+        u8 bag[BAG_SIZE];
+        for (int i = 0; i < BAG_SIZE; ++i) {
+            bag[i] = (u8)(1 + i); // @note Block_Type::EMPTY is 0
+        }
+        for (u32 i = BAG_SIZE - 1; i > 0; --i) {
+            u32 j = random_choice(&generator->series, i + 1);
+            u8 temp = bag[i];
+            bag[i] = bag[j];
+            bag[j] = temp;
+        }
+        
+        for (int i = 0; i < BAG_SIZE; ++i) {
+            u32 write = (generator->queue_read + generator->queue_count) & (PIECE_QUEUE_SIZE - 1);
+            generator->queue[write] = bag[i];
+            ++generator->queue_count;
+        }
+    }
+}
+
+internal void
+init_piece_generator(Piece_Generator *generator, u64 seed) {
+    *generator = {};
+    generator->series = random_seed(seed);
+    refill_piece_queue(generator);
+}
+
+internal enum32(Block_Type)
+next_piece(Piece_Generator *generator) {
+    assert(generator->queue_count > PREVIEW_COUNT);
+    enum32(Block_Type) result = generator->queue[generator->queue_read];
+    generator->queue_read = (generator->queue_read + 1) & (PIECE_QUEUE_SIZE - 1);
+    --generator->queue_count;
+    refill_piece_queue(generator);
+    return result;
+}
+
+// @note preview_index 0 is the piece that spawns next
+inline enum32(Block_Type)
+peek_piece(Piece_Generator *generator, u32 preview_index) {
+    assert(preview_index < PREVIEW_COUNT);
+    enum32(Block_Type) result = generator->queue[(generator->queue_read + preview_index) & (PIECE_QUEUE_SIZE - 1)];
+    return result;
+}
+
+
+#define TETRIS_RANDOM_H
+#endif
@@ -0,0 +1,506 @@
+#include "tetris_render.h"
+
+
+global Vector3 block_colors_by_type[Block_Type::ENUM_SIZE] = {
+    rgb(255,255,255), // Block_Type::EMPTY, should not get rendered
+    
+    rgb(  0, 191, 255),
+    rgb(255, 255, 0  ),
+    rgb(128,   0, 128),
+    rgb(  0, 255, 0  ),
+    rgb(255,   0, 0  ),
+    rgb(  0,   0, 255),
+    rgb(255, 165, 0  )
+};
+
+internal void
+clear_buffer(Game_Offscreen_Buffer *buffer) {
+    TIMED_BLOCK("clear buffer");
+    u8 *row = (u8 *)buffer->memory;
+    for (int y = 0; y < buffer->height; ++y) {
+        u32 *pixel = (u32 *)row;
+        for (int x = 0; x < buffer->width; ++x) {
+            *pixel++ = 0;
+        }
+        
+        row += buffer->pitch;
+    }
+}
+
+inline Render_Rect
+clip_rect(Game_Offscreen_Buffer *buffer, Render_Rect rect) {
+    if (rect.min_x < 0)  rect.min_x = 0;
+    if (rect.min_y < 0)  rect.min_y = 0;
+    if (rect.max_x > buffer->width)   rect.max_x = buffer->width;
+    if (rect.max_y > buffer->height)  rect.max_y = buffer->height;
+    return rect;
+}
+
+// @note unclipped pixel rect of a block at the given pixel position
+inline Render_Rect
+get_tile_rect(s32 min_x, s32 min_y, int scale) {
+    Render_Rect rect;
+    rect.min_x = min_x;
+    rect.min_y = min_y;
+    rect.max_x = min_x + BLOCK_SIZE * scale;
+    rect.max_y = min_y + BLOCK_SIZE * scale;
+    return rect;
+}
+
+inline Render_Rect
+get_block_rect(Game_Offscreen_Buffer *buffer, Vector2 block_pos, int scale) {
+    s32 min_x = ((block_pos.x * BLOCK_SIZE) + ((block_pos.x+1) * BLOCK_GAP_SIZE)) * scale;
+    s32 min_y = ((block_pos.y * BLOCK_SIZE) + ((block_pos.y+1) * BLOCK_GAP_SIZE)) * scale;
+    Render_Rect rect = clip_rect(buffer, get_tile_rect(min_x, min_y, scale));
+    return rect;
+}
+
+inline void
+union_rect(Render_Rect *rect, Render_Rect other) {
+    if (is_rect_empty(other))  return;
+    if (is_rect_empty(*rect)) {
+        *rect = other;
+        return;
+    }
+    if (other.min_x < rect->min_x)  rect->min_x = other.min_x;
+    if (other.min_y < rect->min_y)  rect->min_y = other.min_y;
+    if (other.max_x > rect->max_x)  rect->max_x = other.max_x;
+    if (other.max_y > rect->max_y)  rect->max_y = other.max_y;
+}
+
+inline u32
+get_block_color(enum32(Block_Type) type) {
+    Vector3 color_rgb = block_colors_by_type[(int)type];
+    u32 color = ((color_rgb.r << 16) |
+                 (color_rgb.g << 8)  |
+                 (color_rgb.b << 0));
+    return color;
+}
+
+
+//
+// @note nearest neighbor integer upscaler
+//
+
+// @note dest has to be at least source * scale in both dimensions
+internal void
+upscale_nearest_scalar(Game_Offscreen_Buffer *dest, Game_Offscreen_Buffer *source, int scale) {
+    u8 *source_row = (u8 *)source->memory;
+    u8 *dest_row = (u8 *)dest->memory;
+    for (int y = 0; y < source->height; ++y) {
+        for (int repeat_y = 0; repeat_y < scale; ++repeat_y) {
+            u32 *source_pixel = (u32 *)source_row;
+            u32 *dest_pixel = (u32 *)dest_row;
+            for (int x = 0; x < source->width; ++x) {
+                for (int repeat_x = 0; repeat_x < scale; ++repeat_x) {
+                    *dest_pixel++ = *source_pixel;
+                }
+                ++source_pixel;
+            }
+            dest_row += dest->pitch;
+        }
+        source_row += source->pitch;
+    }
+}
+
+#if TETRIS_X86
+// @note Every source pixel is broadcast and written with 4 wide stores, overshooting into the next pixel's
+//       span which the next pixel overwrites. Pixels whose stores would run past the end of the row
+//       are written one by one. The expanded row is then copied scale-1 times.
+internal void
+upscale_nearest_sse2(Game_Offscreen_Buffer *dest, Game_Offscreen_Buffer *source, int scale) {
+    int dest_row_width = source->width * scale;
+    int chunk_count = (scale + 3) / 4;
+    u8 *source_row = (u8 *)source->memory;
+    u8 *dest_row = (u8 *)dest->memory;
+    for (int y = 0; y < source->height; ++y) {
+        u32 *source_pixel = (u32 *)source_row;
+        u32 *dest_pixel = (u32 *)dest_row;
+        for (int x = 0; x < source->width; ++x) {
+            u32 *span = dest_pixel + x*scale;
+            if (x*scale + chunk_count*4 <= dest_row_width) {
+                __m128i value = _mm_set1_epi32((int)source_pixel[x]);
+                for (int chunk = 0; chunk < chunk_count; ++chunk) {
+                    _mm_storeu_si128((__m128i *)(span + chunk*4), value);
+                }
+            }
+            else {
+                for (int repeat_x = 0; repeat_x < scale; ++repeat_x) {
+                    span[repeat_x] = source_pixel[x];
+                }
+            }
+        }
+        
+        u8 *expanded_row = dest_row;
+        dest_row += dest->pitch;
+        for (int repeat_y = 1; repeat_y < scale; ++repeat_y) {
+            memcpy(dest_row, expanded_row, dest_row_width * sizeof(u32));
+            dest_row += dest->pitch;
+        }
+        source_row += source->pitch;
+    }
+}
+#endif
+
+internal void
+upscale_nearest(Game_Offscreen_Buffer *dest, Game_Offscreen_Buffer *source, int scale) {
+    assert(dest->width >= source->width * scale && dest->height >= source->height * scale);
+#if TETRIS_X86
+    upscale_nearest_sse2(dest, source, scale);
+#else
+    upscale_nearest_scalar(dest, source, scale);
+#endif
+}
+
+
+//
+// @note block tiles and blitters
+//
+
+global Block_Tiles global_block_tiles;
+global Cpu_Features global_cpu_features;
+
+internal
+BLIT_TILE_SIG(blit_tile_scalar) {
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            dest[x] = source[x];
+        }
+        dest = (u32 *)((u8 *)dest + dest_pitch);
+        source += source_pitch;
+    }
+}
+
+#if TETRIS_X86
+// @note 4 pixels per store, the tail is written by an overlapping store ending at the last pixel
+internal
+BLIT_TILE_SIG(blit_tile_sse2) {
+    if (width < 4) {
+        blit_tile_scalar(dest, dest_pitch, source, source_pitch, width, height);
+        return;
+    }
+    for (int y = 0; y < height; ++y) {
+        int x = 0;
+        for (; x + 4 <= width; x += 4) {
+            _mm_storeu_si128((__m128i *)(dest + x), _mm_loadu_si128((const __m128i *)(source + x)));
+        }
+        if (x < width) {
+            x = width - 4;
+            _mm_storeu_si128((__m128i *)(dest + x), _mm_loadu_si128((const __m128i *)(source + x)));
+        }
+        dest = (u32 *)((u8 *)dest + dest_pitch);
+        source += source_pitch;
+    }
+}
+
+// @note 8 pixels per store, the tail is a masked store so nothing outside the tile gets touched
+internal TARGET_AVX2
+BLIT_TILE_SIG(blit_tile_avx2) {
+    int tail = width & 7;
+    __m256i tail_mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(tail), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    for (int y = 0; y < height; ++y) {
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            _mm256_storeu_si256((__m256i *)(dest + x), _mm256_loadu_si256((const __m256i *)(source + x)));
+        }
+        if (tail) {
+            _mm256_maskstore_epi32((int *)(dest + x), tail_mask, _mm256_loadu_si256((const __m256i *)(source + x)));
+        }
+        dest = (u32 *)((u8 *)dest + dest_pitch);
+        source += source_pitch;
+    }
+}
+#endif
+
+global Blit_Tile_Sig *blit_tile = blit_tile_scalar;
+
+// @note rasterizes the tiles at native size and upscales them, only called when the render scale changes
+internal void
+build_block_tiles(Block_Tiles *tiles, int scale) {
+    assert(scale >= 1 && scale <= MAX_RENDER_SCALE);
+    tiles->scale = scale;
+    tiles->size = BLOCK_SIZE * scale;
+    tiles->pitch = (tiles->size + 7) & ~7;
+    
+    for (int type = Block_Type::EMPTY + 1; type < Block_Type::ENUM_SIZE; ++type) {
+        u32 native[BLOCK_SIZE][BLOCK_SIZE];
+        u32 color = get_block_color(type);
+        for (int y = 0; y < BLOCK_SIZE; ++y) {
+            for (int x = 0; x < BLOCK_SIZE; ++x) {
+                native[y][x] = color;
+            }
+        }
+        // @note highlight in the top left corner
+        native[0][0] = 0xFFFFFFFF;
+        native[1][1] = 0xFFFFFFFF;
+        native[2][1] = 0xFFFFFFFF;
+        native[1][2] = 0xFFFFFFFF;
+        
+        Game_Offscreen_Buffer source = { native, BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE * 4, 4 };
+        Game_Offscreen_Buffer dest = { tiles->pixels[type], tiles->size, tiles->size, tiles->pitch * 4, 4 };
+        upscale_nearest(&dest, &source, scale);
+        
+        // @note ghost, a one pixel outline at half brightness
+        u32 ghost_color = (color >> 1) & 0x7F7F7F;
+        for (int y = 0; y < BLOCK_SIZE; ++y) {
+            for (int x = 0; x < BLOCK_SIZE; ++x) {
+                b32 is_edge = (x == 0 || y == 0 || x == BLOCK_SIZE - 1 || y == BLOCK_SIZE - 1);
+                native[y][x] = is_edge ? ghost_color : 0;
+            }
+        }
+        Game_Offscreen_Buffer ghost_dest = { tiles->pixels[GHOST_TILE_BASE + type], tiles->size, tiles->size, tiles->pitch * 4, 4 };
+        upscale_nearest(&ghost_dest, &source, scale);
+    }
+    
+    blit_tile = blit_tile_scalar;
+#if TETRIS_X86
+    if (global_cpu_features.sse2)  blit_tile = blit_tile_sse2;
+    // @note for tiles narrower than 8 pixels the masked store is slower than two overlapping sse2 stores (see tetris_bench)
+    if (global_cpu_features.avx2 && tiles->size >= 8)  blit_tile = blit_tile_avx2;
+#endif
+}
+
+// @note detects the cpu features and builds the native tiles, call once at startup
+internal void
+init_renderer() {
+    global_cpu_features = get_cpu_features();
+    build_block_tiles(&global_block_tiles, 1);
+}
+
+// @note draws a tile with its top left corner at any pixel position, clipped to the buffer, type can also be a ghost tile
+internal void
+render_tile(Game_Offscreen_Buffer *buffer, s32 min_x, s32 min_y, u32 type) {
+    if (type == Block_Type::EMPTY)  return;
+    
+    Render_Rect rect = clip_rect(buffer, get_tile_rect(min_x, min_y, global_block_tiles.scale));
+    if (is_rect_empty(rect))  return;
+    
+    // @note if the block is clipped, start inside the tile
+    const u32 *source = (global_block_tiles.pixels[type] +
+                         (rect.min_y - min_y) * global_block_tiles.pitch +
+                         (rect.min_x - min_x));
+    u32 *dest = (u32 *)((u8 *)buffer->memory +
+                        rect.min_x * buffer->bytes_per_pixel +
+                        rect.min_y * buffer->pitch);
+    blit_tile(dest, buffer->pitch, source, global_block_tiles.pitch,
+              rect.max_x - rect.min_x, rect.max_y - rect.min_y);
+}
+
+internal void
+render_block(Game_Offscreen_Buffer *buffer, Vector2 block_pos, u32 type) {
+    int scale = global_block_tiles.scale;
+    s32 min_x = ((block_pos.x * BLOCK_SIZE) + ((block_pos.x+1) * BLOCK_GAP_SIZE)) * scale;
+    s32 min_y = ((block_pos.y * BLOCK_SIZE) + ((block_pos.y+1) * BLOCK_GAP_SIZE)) * scale;
+    render_tile(buffer, min_x, min_y, type);
+}
+
+// @note per pixel version with the highlight test at native scale, only used as reference for the tiles
+//       (see tetris_bench, tetris_headless --verify)
+internal void
+render_block_reference(Game_Offscreen_Buffer *buffer, Vector2 block_pos, enum32(Block_Type) type) {
+    if (type == Block_Type::EMPTY)  return;
+    Vector3 color_rgb = block_colors_by_type[(int)type];
+    //
+    Render_Rect rect = get_block_rect(buffer, block_pos, 1);
+    s32 min_x = (block_pos.x * BLOCK_SIZE) + ((block_pos.x+1) * BLOCK_GAP_SIZE);
+    s32 min_y = (block_pos.y * BLOCK_SIZE) + ((block_pos.y+1) * BLOCK_GAP_SIZE);
+    
+    u32 color = ((color_rgb.r << 16) |
+                 (color_rgb.g << 8)  |
+                 (color_rgb.b << 0));
+    
+    u8 *row = ((u8 *)buffer->memory +
+               rect.min_x * buffer->bytes_per_pixel +
+               rect.min_y * buffer->pitch);
+    for (int y = rect.min_y; y < rect.max_y; ++y) {
+        u32 *pixel = (u32 *)row;
+        for (int x = rect.min_x; x < rect.max_x; ++x) {
+            u32 _color = color;
+            if ((x==(min_x+0) && y==(min_y+0)) ||
+                (x==(min_x+1) && y==(min_y+1)) ||
+                (x==(min_x+1) && y==(min_y+2)) ||
+                (x==(min_x+2) && y==(min_y+1))) {
+                _color = 0xFFFFFFFF;
+            }
+            
+            *pixel = _color;
+            ++pixel;
+        }
+        row += buffer->pitch;
+    }
+}
+
+internal void
+fill_rect(Game_Offscreen_Buffer *buffer, Render_Rect rect, u32 color) {
+    u8 *row = ((u8 *)buffer->memory +
+               rect.min_x * buffer->bytes_per_pixel +
+               rect.min_y * buffer->pitch);
+    for (int y = rect.min_y; y < rect.max_y; ++y) {
+        u32 *pixel = (u32 *)row;
+        for (int x = rect.min_x; x < rect.max_x; ++x) {
+            *pixel++ = color;
+        }
+        row += buffer->pitch;
+    }
+}
+
+// @note fills the cell with the background color, the gaps around it are left untouched
+internal void
+clear_block(Game_Offscreen_Buffer *buffer, Vector2 block_pos) {
+    Render_Rect rect = get_block_rect(buffer, block_pos, global_block_tiles.scale);
+    fill_rect(buffer, rect, 0);
+}
+
+// @note Pixel offset of the current_block from its grid position, interpolated tick_alpha of the way from
+//       previous_block. Zero if the block did not just move by one cell, rotations and new pieces snap.
+internal Vector2
+get_floating_block_offset(Game_State *game_state, f32 tick_alpha, int scale) {
+    Vector2 result = {};
+    Block *block = &game_state->current_block;
+    Block *previous = &game_state->previous_block;
+    if (previous->type != block->type || previous->rotation != block->rotation)  return result;
+    
+    int dx = previous->origin.x - block->origin.x;
+    int dy = previous->origin.y - block->origin.y;
+    if (dx < -1 || dx > 1 || dy < -1 || dy > 1)  return result;
+    
+    f32 remaining = 1.0f - tick_alpha;
+    if (remaining < 0.0f)  remaining = 0.0f;
+    if (remaining > 1.0f)  remaining = 1.0f;
+    int cell_pitch = CELL_PITCH * scale;
+    result.x = (int)((f32)(dx * cell_pitch) * remaining);
+    result.y = (int)((f32)(dy * cell_pitch) * remaining);
+    return result;
+}
+
+// @note Incremental renderer, only cells whose Block_Type changed since the last call get redrawn.
+//       The current_block is composited into the cells, so its old and new positions are covered by the same diff.
+//       While it is interpolated between two cells it is drawn on top instead, and the cells under it are redrawn next frame.
+//       The ghost piece, where the current_block would land, is composited into the cells the same way.
+//       render_state->dirty_rect is empty if nothing changed, the platform layer can skip presenting then.
+//       The render scale follows from the buffer width, the tiles get rebuilt when it changes.
+internal void
+render_game(Render_State *render_state, Game_Offscreen_Buffer *buffer, Game_State *game_state, f32 tick_alpha = 1.0f) {
+    TIMED_BLOCK("grid render");
+    int scale = get_render_scale(buffer->width, buffer->height);
+    if (global_block_tiles.scale != scale)  build_block_tiles(&global_block_tiles, scale);
+    if (render_state->scale != scale) {
+        render_state->scale = scale;
+        render_state->is_valid = false;
+    }
+    
+    Block *block = &game_state->current_block;
+    Vector2 floating_offset = get_floating_block_offset(game_state, tick_alpha, scale);
+    b32 is_floating = (floating_offset.x != 0 || floating_offset.y != 0);
+    
+    u8 cells[GRID_HEIGHT][GRID_WIDTH];
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            cells[y][x] = (u8)game_state->grid[y][x];
+        }
+    }
+    int drop_distance = get_drop_distance(game_state, block->type, block->rotation, block->origin.x, block->origin.y);
+    if (drop_distance > 0) {
+        for (int i = 0; i < 4; ++i) {
+            cells[block->pos[i].y + drop_distance][block->pos[i].x] = (u8)(GHOST_TILE_BASE + block->type);
+        }
+    }
+    if (!is_floating) {
+        for (int i = 0; i < 4; ++i) {
+            cells[block->pos[i].y][block->pos[i].x] = (u8)block->type;
+        }
+    }
+    
+    render_state->dirty_rect = {};
+    if (!render_state->is_valid) {
+        clear_buffer(buffer);
+        for (int y = 0; y < GRID_HEIGHT; ++y) {
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                render_block(buffer, Vector2{x,y}, cells[y][x]);
+            }
+        }
+        render_state->dirty_rect = { 0, 0, buffer->width, buffer->height };
+        render_state->is_valid = true;
+    }
+    else {
+        if (render_state->has_floating_block) {
+            // @note erase last frame's floating block including the gaps it covered, the cells under it get redrawn below
+            int cell_pitch = CELL_PITCH * scale;
+            for (int i = 0; i < 4; ++i) {
+                Render_Rect rect = render_state->floating_block_rects[i];
+                fill_rect(buffer, rect, 0);
+                union_rect(&render_state->dirty_rect, rect);
+                
+                int min_cell_x = rect.min_x / cell_pitch;
+                int min_cell_y = rect.min_y / cell_pitch;
+                int max_cell_x = (rect.max_x - 1) / cell_pitch;
+                int max_cell_y = (rect.max_y - 1) / cell_pitch;
+                for (int y = min_cell_y; y <= max_cell_y && y < GRID_HEIGHT; ++y) {
+                    for (int x = min_cell_x; x <= max_cell_x && x < GRID_WIDTH; ++x) {
+                        render_state->drawn_cells[y][x] = 0xFF;
+                    }
+                }
+            }
+        }
+        
+        for (int y = 0; y < GRID_HEIGHT; ++y) {
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                u8 type = cells[y][x];
+                if (type == render_state->drawn_cells[y][x])  continue;
+                
+                Vector2 block_pos = Vector2{x,y};
+                if (type == Block_Type::EMPTY)  clear_block(buffer, block_pos);
+                else                            render_block(buffer, block_pos, type);
+                union_rect(&render_state->dirty_rect, get_block_rect(buffer, block_pos, scale));
+            }
+        }
+    }
+    
+    render_state->has_floating_block = is_floating;
+    if (is_floating) {
+        for (int i = 0; i < 4; ++i) {
+            s32 min_x = ((block->pos[i].x * BLOCK_SIZE) + ((block->pos[i].x+1) * BLOCK_GAP_SIZE)) * scale + floating_offset.x;
+            s32 min_y = ((block->pos[i].y * BLOCK_SIZE) + ((block->pos[i].y+1) * BLOCK_GAP_SIZE)) * scale + floating_offset.y;
+            render_tile(buffer, min_x, min_y, block->type);
+            
+            Render_Rect rect = clip_rect(buffer, get_tile_rect(min_x, min_y, scale));
+            render_state->floating_block_rects[i] = rect;
+            union_rect(&render_state->dirty_rect, rect);
+        }
+    }
+    
+    memcpy(render_state->drawn_cells, cells, sizeof(cells));
+}
+
+#if TETRIS_PROFILE && TETRIS_X86
+global u32 debug_overlay_colors[] = {
+    0xFFE6194B, 0xFF3CB44B, 0xFFFFE119, 0xFF4363D8, 0xFFF58231, 0xFF911EB4,
+    0xFF46F0F0, 0xFFF032E6, 0xFFBCF60C, 0xFFFABEBE, 0xFF008080, 0xFFE6BEFF,
+};
+
+// @note One bar per timing site along the top of the buffer, scaled so the full width is budget_cycles.
+//       Sites are ordered by __COUNTER__ and colored from debug_overlay_colors, red behind a bar means over budget.
+//       Draws over the game, the caller has to invalidate the render_state so the next frame redraws everything.
+internal void
+render_debug_overlay(Game_Offscreen_Buffer *buffer, u64 budget_cycles) {
+    Debug_Frame *frame = get_last_debug_frame();
+    if (!frame || budget_cycles == 0)  return;
+    
+    int bar_height = 2 * global_block_tiles.scale;
+    int y = 0;
+    for (u32 record_index = 0; record_index < global_debug_state.record_count; ++record_index) {
+        Debug_Frame_Record *record = &frame->records[record_index];
+        if (!global_debug_state.records[record_index].name)  continue;
+        
+        u64 cycles = record->cycles;
+        b32 over_budget = (cycles > budget_cycles);
+        if (over_budget)  cycles = budget_cycles;
+        int bar_width = (int)(((u64)buffer->width * cycles) / budget_cycles);
+        Render_Rect background = clip_rect(buffer, Render_Rect{ 0, y, buffer->width, y + bar_height });
+        Render_Rect bar = clip_rect(buffer, Render_Rect{ 0, y, bar_width, y + bar_height });
+        fill_rect(buffer, background, over_budget ? 0xFFFF0000 : 0xFF202020);
+        fill_rect(buffer, bar, debug_overlay_colors[record_index % array_count(debug_overlay_colors)]);
+        y += bar_height + global_block_tiles.scale;
+    }
+}
+#endif
@@ -0,0 +1,85 @@
+#if !defined(TETRIS_RENDER_H)
+
+// @note Platform independent software renderer, draws into a plain 32 bit memory buffer.
+//       The buffer is WIDTH x HEIGHT times an integer scale, the renderer draws directly at that resolution.
+
+
+#define BLOCK_SIZE 7
+
+#define BLOCK_GAP_SIZE 1
+
+#define WIDTH  ((GRID_WIDTH * BLOCK_SIZE) + ((GRID_WIDTH+1) * BLOCK_GAP_SIZE))
+#define HEIGHT ((GRID_HEIGHT * BLOCK_SIZE) + ((GRID_HEIGHT+1) * BLOCK_GAP_SIZE))
+
+#define MAX_RENDER_SCALE 16
+
+
+struct Game_Offscreen_Buffer {
+    void *memory;
+    int width;
+    int height;
+    int pitch;
+    int bytes_per_pixel;
+};
+
+// @note Pre-rasterized block tiles with the highlight baked in, scaled to the current render scale.
+//       Rows are padded to a multiple of 8 pixels, so the simd blitters can always load whole 256 bit rows.
+#define MAX_TILE_SIZE (BLOCK_SIZE * MAX_RENDER_SCALE)
+#define MAX_TILE_PITCH ((MAX_TILE_SIZE + 7) & ~7)
+
+// @note the ghost piece's tiles follow the block tiles, tile GHOST_TILE_BASE + type is the outline of type
+#define GHOST_TILE_BASE Block_Type::ENUM_SIZE
+#define TILE_COUNT (2 * Block_Type::ENUM_SIZE)
+
+struct Block_Tiles {
+    int scale; // @note 0 if the tiles were not built yet
+    int size;  // @note width and height of a tile in pixels
+    int pitch; // @note u32 per tile row
+    u32 pixels[TILE_COUNT][MAX_TILE_SIZE * MAX_TILE_PITCH];
+    u32 read_padding[8]; // @note a clipped blit of the last row can read up to 7 pixels past the end
+};
+
+// @note copies width x height pixels, source rows are source_pitch u32 apart and readable up to a multiple of 8 pixels
+#define BLIT_TILE_SIG(name) void name(u32 *dest, int dest_pitch, const u32 *source, int source_pitch, int width, int height)
+typedef BLIT_TILE_SIG(Blit_Tile_Sig);
+
+// @note pixel rectangle, max is exclusive, empty if min >= max
+struct Render_Rect {
+    int min_x;
+    int min_y;
+    int max_x;
+    int max_y;
+};
+
+// @note distance between two cells at scale 1
+#define CELL_PITCH (BLOCK_SIZE + BLOCK_GAP_SIZE)
+
+struct Render_State {
+    b32 is_valid; // @note false forces a full redraw, e.g. on the first frame or after the buffer got resized
+    int scale;
+    u8 drawn_cells[GRID_HEIGHT][GRID_WIDTH]; // @note tile drawn into each cell last frame, including the current_block if it sat on the grid and the ghost
+    b32 has_floating_block; // @note the current_block was drawn between cells last frame, over floating_block_rects
+    Render_Rect floating_block_rects[4];
+    Render_Rect dirty_rect; // @note pixels that changed during the last render_game call
+};
+
+inline b32
+is_rect_empty(Render_Rect rect) {
+    b32 result = ((rect.min_x >= rect.max_x) || (rect.min_y >= rect.max_y));
+    return result;
+}
+
+// @note largest integer scale at which the game fits into the given size, at least 1
+inline int
+get_render_scale(int width, int height) {
+    int scale_x = width / WIDTH;
+    int scale_y = height / HEIGHT;
+    int scale = (scale_x < scale_y) ? scale_x : scale_y;
+    if (scale < 1)  scale = 1;
+    if (scale > MAX_RENDER_SCALE)  scale = MAX_RENDER_SCALE;
+    return scale;
+}
+
+
+#define TETRIS_RENDER_H
+#endif
@@ -0,0 +1,472 @@
+#if !defined(TETRIS_REPLAY_H)
+
+// @note Input recording and replay. A replay is the seed, tick rate and gravity mode plus every game_step call's input and
+//       tick count, replaying it from init_game reproduces the session bit for bit. The final state checksum
+//       is stored at the end, so a replay also works as a regression test and a fixed benchmark workload.
+//       The steps are stored in chunks of REPLAY_KEYFRAME_INTERVAL. A chunk starts with a Snapshot of the game
+//       before its first step, the keyframe, followed by its steps as runs: a control byte, only the fields that
+//       changed from the previous run and how often the step repeats. A held button or an idle stick costs a
+//       byte per run instead of a Replay_Step per frame. The keyframe index at the end of the file lets
+//       seek_replay jump to any step by loading the keyframe before it and simulating at most a chunk.
+//       Fields are written little endian as they are in memory. Needs stdio.h and stdlib.h from the platform
+//       layer and tetris_snapshot.h.
+
+
+#define REPLAY_MAGIC 0x50525454 // @note "TTRP"
+#define REPLAY_VERSION 3 // @note 2: move_up hard drops, instant_gravity in the header 3: runs and keyframes
+#define REPLAY_KEYFRAME_INTERVAL 256 // @note steps per chunk, a seek simulates at most this many
+
+struct Replay_Header {
+    u32 magic;
+    u32 version;
+    u64 seed;
+    u32 tick_hz;
+    b32 instant_gravity;
+    u32 keyframe_interval;
+    u32 snapshot_size; // @note sizeof(Snapshot), to reject files from a different layout
+    u64 step_count;
+    u64 final_tick_count;
+    u64 final_checksum; // @note get_game_state_checksum after the last step
+    u64 index_offset;   // @note file offset of the keyframe_count Replay_Keyframes, 8 byte aligned, they end the file
+    u32 keyframe_count;
+    u32 reserved;
+};
+
+// @note keyframe i is the state before step i * keyframe_interval, the chunk's steps follow its snapshot
+struct Replay_Keyframe {
+    u64 step_index;
+    u64 offset; // @note file offset of the Snapshot
+};
+
+// @note one game_step call, frames without a tick are merged into the next step and not recorded
+struct Replay_Step {
+    u32 ticks;
+    u16 buttons; // @note bit i is buttons[i].ended_down
+    u16 flags;   // @note REPLAY_STEP_*
+    f32 stick_average_x;
+    f32 stick_average_y;
+};
+
+#define REPLAY_STEP_IS_CONNECTED (1 << 0)
+#define REPLAY_STEP_IS_ANALOG    (1 << 1)
+
+// @note The control byte of a run. The low bits say which fields follow, in this order: ticks as a varint,
+//       the buttons xor the previous run's as a varint, the flags as a byte, both stick floats. The high bits
+//       are the repeat count minus one, REPLAY_RUN_LONG means a varint with the repeat count minus
+//       REPLAY_RUN_LONG + 1 follows the fields. Every chunk starts from a zero Replay_Step.
+#define REPLAY_RUN_TICKS   (1 << 0)
+#define REPLAY_RUN_BUTTONS (1 << 1)
+#define REPLAY_RUN_FLAGS   (1 << 2)
+#define REPLAY_RUN_STICK   (1 << 3)
+#define REPLAY_RUN_REPEAT_SHIFT 4
+#define REPLAY_RUN_LONG 15
+
+#define MAX_REPLAY_RUN_SIZE 32
+
+typedef bool __check_replay_step_size__[sizeof(Replay_Step) == 16 ? 1 : -1];
+typedef bool __check_replay_buttons__[array_count(((Game_Controller_Input *)0)->buttons) <= 16 ? 1 : -1];
+typedef bool __check_replay_header_size__[(sizeof(Replay_Header) % 8) == 0 ? 1 : -1];
+
+inline Replay_Step
+encode_replay_step(const Game_Controller_Input *controller, u32 ticks) {
+    Replay_Step step = {};
+    step.ticks = ticks;
+    if (controller) {
+        for (int button_index = 0; button_index < (int)array_count(controller->buttons); ++button_index) {
+            if (controller->buttons[button_index].ended_down)  step.buttons |= (u16)(1 << button_index);
+        }
+        if (controller->is_connected)  step.flags |= REPLAY_STEP_IS_CONNECTED;
+        if (controller->is_analog)     step.flags |= REPLAY_STEP_IS_ANALOG;
+        step.stick_average_x = controller->stick_average_x;
+        step.stick_average_y = controller->stick_average_y;
+    }
+    return step;
+}
+
+inline Game_Controller_Input
+decode_replay_step(Replay_Step *step) {
+    Game_Controller_Input controller = {};
+    for (int button_index = 0; button_index < (int)array_count(controller.buttons); ++button_index) {
+        controller.buttons[button_index].ended_down = (step->buttons >> button_index) & 1;
+    }
+    controller.is_connected = (step->flags & REPLAY_STEP_IS_CONNECTED) != 0;
+    controller.is_analog = (step->flags & REPLAY_STEP_IS_ANALOG) != 0;
+    controller.stick_average_x = step->stick_average_x;
+    controller.stick_average_y = step->stick_average_y;
+    return controller;
+}
+
+inline u32
+put_replay_varint(u8 *buffer, u64 value) {
+    u32 size = 0;
+    while (value >= 0x80) {
+        buffer[size++] = (u8)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[size++] = (u8)value;
+    return size;
+}
+
+inline b32
+get_replay_varint(u8 **at, u8 *end, u64 *value) {
+    *value = 0;
+    for (u32 shift = 0; shift < 64; shift += 7) {
+        if (*at == end)  return false;
+        u8 byte = *(*at)++;
+        *value |= (u64)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))  return true;
+    }
+    return false;
+}
+
+// @note encodes repeat_count times step after previous into buffer, returns the size
+internal u32
+encode_replay_run(u8 *buffer, Replay_Step *previous, Replay_Step *step, u32 repeat_count) {
+    assert(repeat_count > 0);
+    u8 control = 0;
+    u32 size = 1;
+    if (step->ticks != previous->ticks) {
+        control |= REPLAY_RUN_TICKS;
+        size += put_replay_varint(buffer + size, step->ticks);
+    }
+    if (step->buttons != previous->buttons) {
+        control |= REPLAY_RUN_BUTTONS;
+        size += put_replay_varint(buffer + size, (u16)(step->buttons ^ previous->buttons));
+    }
+    if (step->flags != previous->flags) {
+        control |= REPLAY_RUN_FLAGS;
+        buffer[size++] = (u8)step->flags;
+    }
+    // @note compared bit for bit, -0.0f has to come back as -0.0f
+    if (memcmp(&step->stick_average_x, &previous->stick_average_x, 2 * sizeof(f32)) != 0) {
+        control |= REPLAY_RUN_STICK;
+        memcpy(buffer + size, &step->stick_average_x, 2 * sizeof(f32));
+        size += 2 * sizeof(f32);
+    }
+    if (repeat_count - 1 < REPLAY_RUN_LONG) {
+        control |= (u8)((repeat_count - 1) << REPLAY_RUN_REPEAT_SHIFT);
+    }
+    else {
+        control |= (u8)(REPLAY_RUN_LONG << REPLAY_RUN_REPEAT_SHIFT);
+        size += put_replay_varint(buffer + size, repeat_count - (REPLAY_RUN_LONG + 1));
+    }
+    buffer[0] = control;
+    assert(size <= MAX_REPLAY_RUN_SIZE);
+    return size;
+}
+
+// @note decodes the run at *at over step, which holds the previous run, false if it does not fit before end
+internal b32
+decode_replay_run(u8 **at, u8 *end, Replay_Step *step, u64 *repeat_count) {
+    if (*at == end)  return false;
+    u8 control = *(*at)++;
+    u64 value;
+    if (control & REPLAY_RUN_TICKS) {
+        if (!get_replay_varint(at, end, &value) || value == 0 || value > 0xFFFFFFFF)  return false;
+        step->ticks = (u32)value;
+    }
+    if (control & REPLAY_RUN_BUTTONS) {
+        if (!get_replay_varint(at, end, &value) || value > 0xFFFF)  return false;
+        step->buttons ^= (u16)value;
+    }
+    if (control & REPLAY_RUN_FLAGS) {
+        if (*at == end)  return false;
+        step->flags = *(*at)++;
+    }
+    if (control & REPLAY_RUN_STICK) {
+        if (end - *at < (s64)(2 * sizeof(f32)))  return false;
+        memcpy(&step->stick_average_x, *at, 2 * sizeof(f32));
+        *at += 2 * sizeof(f32);
+    }
+    *repeat_count = (u64)(control >> REPLAY_RUN_REPEAT_SHIFT) + 1;
+    if ((control >> REPLAY_RUN_REPEAT_SHIFT) == REPLAY_RUN_LONG) {
+        if (!get_replay_varint(at, end, &value) || value > 0xFFFFFFFF)  return false;
+        *repeat_count += value;
+    }
+    return step->ticks != 0;
+}
+
+
+//
+// @note recording
+//
+
+struct Replay_Recorder {
+    FILE *file; // @note 0 if not recording
+    Replay_Header header;
+    u64 offset; // @note bytes written so far
+    b32 write_failed;
+    
+    // @note the run being collected and the one before it, the base of the deltas
+    Replay_Step run_step;
+    u32 run_count;
+    Replay_Step previous_step;
+    
+    Replay_Keyframe *keyframes; // @note malloc'd, written as the index by end_replay_recording
+    u32 keyframe_capacity;
+};
+
+inline void
+write_replay_bytes(Replay_Recorder *recorder, void *data, u32 size) {
+    if (fwrite(data, size, 1, recorder->file) != 1)  recorder->write_failed = true;
+    recorder->offset += size;
+}
+
+internal void
+flush_replay_run(Replay_Recorder *recorder) {
+    if (recorder->run_count == 0)  return;
+    u8 buffer[MAX_REPLAY_RUN_SIZE];
+    u32 size = encode_replay_run(buffer, &recorder->previous_step, &recorder->run_step, recorder->run_count);
+    write_replay_bytes(recorder, buffer, size);
+    recorder->previous_step = recorder->run_step;
+    recorder->run_count = 0;
+}
+
+// @note game_state has to come straight from init_game, the header is rewritten by end_replay_recording
+internal b32
+begin_replay_recording(Replay_Recorder *recorder, FILE *file, Game_State *game_state) {
+    *recorder = {};
+    if (!file)  return false;
+    recorder->file = file;
+    recorder->header.magic = REPLAY_MAGIC;
+    recorder->header.version = REPLAY_VERSION;
+    recorder->header.seed = game_state->seed;
+    recorder->header.tick_hz = game_state->tick_hz;
+    recorder->header.instant_gravity = game_state->instant_gravity;
+    recorder->header.keyframe_interval = REPLAY_KEYFRAME_INTERVAL;
+    recorder->header.snapshot_size = sizeof(Snapshot);
+    write_replay_bytes(recorder, &recorder->header, sizeof(recorder->header));
+    return !recorder->write_failed;
+}
+
+// @note call with exactly what was passed to game_step and the state before it, steps without ticks are skipped
+internal void
+record_replay_step(Replay_Recorder *recorder, Game_State *game_state, const Game_Controller_Input *controller, u32 ticks) {
+    if (!recorder->file || ticks == 0)  return;
+    Replay_Step step = encode_replay_step(controller, ticks);
+    
+    if ((recorder->header.step_count % REPLAY_KEYFRAME_INTERVAL) == 0) {
+        flush_replay_run(recorder);
+        if (recorder->header.keyframe_count == recorder->keyframe_capacity) {
+            u32 capacity = recorder->keyframe_capacity ? 2 * recorder->keyframe_capacity : 64;
+            Replay_Keyframe *keyframes = (Replay_Keyframe *)realloc(recorder->keyframes, capacity * sizeof(Replay_Keyframe));
+            if (!keyframes) {
+                recorder->write_failed = true;
+                return;
+            }
+            recorder->keyframes = keyframes;
+            recorder->keyframe_capacity = capacity;
+        }
+        Replay_Keyframe *keyframe = &recorder->keyframes[recorder->header.keyframe_count++];
+        keyframe->step_index = recorder->header.step_count;
+        keyframe->offset = recorder->offset;
+        Snapshot snapshot;
+        save_snapshot(game_state, &snapshot);
+        write_replay_bytes(recorder, &snapshot, sizeof(snapshot));
+        recorder->previous_step = {};
+    }
+    
+    if (recorder->run_count > 0 && memcmp(&step, &recorder->run_step, sizeof(step)) == 0) {
+        ++recorder->run_count;
+    }
+    else {
+        flush_replay_run(recorder);
+        recorder->run_step = step;
+        recorder->run_count = 1;
+    }
+    ++recorder->header.step_count;
+}
+
+// @note writes the last run, the index and the final checksum, the file stays open and belongs to the caller
+internal b32
+end_replay_recording(Replay_Recorder *recorder, Game_State *game_state) {
+    if (!recorder->file)  return false;
+    flush_replay_run(recorder);
+    u8 padding[8] = {};
+    if (recorder->offset % 8)  write_replay_bytes(recorder, padding, (u32)(8 - recorder->offset % 8));
+    recorder->header.index_offset = recorder->offset;
+    if (recorder->header.keyframe_count) {
+        write_replay_bytes(recorder, recorder->keyframes, recorder->header.keyframe_count * sizeof(Replay_Keyframe));
+    }
+    recorder->header.final_tick_count = game_state->tick_count;
+    recorder->header.final_checksum = get_game_state_checksum(game_state);
+    b32 result = (!recorder->write_failed &&
+                  fseek(recorder->file, 0, SEEK_SET) == 0 &&
+                  fwrite(&recorder->header, sizeof(recorder->header), 1, recorder->file) == 1 &&
+                  fflush(recorder->file) == 0);
+    free(recorder->keyframes);
+    recorder->keyframes = 0;
+    recorder->file = 0;
+    return result;
+}
+
+
+//
+// @note playback
+//
+
+struct Replay {
+    Replay_Header header;
+    u8 *data; // @note malloc'd, the whole file, free_replay
+    Replay_Keyframe *keyframes; // @note in data
+};
+
+// @note reads through a replay's steps, one chunk after the other
+struct Replay_Cursor {
+    u8 *at;
+    u8 *end; // @note of the current chunk
+    u32 keyframe_index;
+    Replay_Step step;
+    u64 run_remaining;
+    u64 step_index; // @note of the next step
+    u64 chunk_end_step_index;
+};
+
+// @note loads the whole replay, playback should not wait on the disk
+internal b32
+load_replay(FILE *file, Replay *replay) {
+    *replay = {};
+    if (!file)  return false;
+    Replay_Header header;
+    if (fread(&header, sizeof(header), 1, file) != 1)  return false;
+    if (header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION || header.snapshot_size != sizeof(Snapshot) ||
+        header.tick_hz == 0 || header.tick_hz > MAX_TICK_HZ || header.keyframe_interval == 0) {
+        return false;
+    }
+    u64 expected_keyframe_count = (header.step_count + header.keyframe_interval - 1) / header.keyframe_interval;
+    if (header.keyframe_count != expected_keyframe_count || header.index_offset < sizeof(header) ||
+        (header.index_offset % 8) != 0) {
+        return false;
+    }
+    
+    u64 size = header.index_offset + header.keyframe_count * sizeof(Replay_Keyframe);
+    u8 *data = (u8 *)malloc((size_t)size);
+    if (!data)  return false;
+    memcpy(data, &header, sizeof(header));
+    if (fread(data + sizeof(header), 1, (size_t)(size - sizeof(header)), file) != (size_t)(size - sizeof(header))) {
+        free(data);
+        return false;
+    }
+    
+    // @note keyframes in order, each chunk at least as large as its snapshot
+    Replay_Keyframe *keyframes = (Replay_Keyframe *)(data + header.index_offset);
+    for (u32 i = 0; i < header.keyframe_count; ++i) {
+        u64 chunk_end = (i + 1 < header.keyframe_count) ? keyframes[i + 1].offset : header.index_offset;
+        if (keyframes[i].step_index != (u64)i * header.keyframe_interval || keyframes[i].offset < sizeof(header) ||
+            keyframes[i].offset > chunk_end || chunk_end - keyframes[i].offset < sizeof(Snapshot)) {
+            free(data);
+            return false;
+        }
+    }
+    
+    replay->header = header;
+    replay->data = data;
+    replay->keyframes = keyframes;
+    return true;
+}
+
+internal void
+free_replay(Replay *replay) {
+    free(replay->data);
+    replay->data = 0;
+    replay->keyframes = 0;
+}
+
+inline void
+get_replay_keyframe(Replay *replay, u32 keyframe_index, Snapshot *snapshot) {
+    memcpy(snapshot, replay->data + replay->keyframes[keyframe_index].offset, sizeof(*snapshot));
+}
+
+internal void
+begin_replay_chunk(Replay *replay, Replay_Cursor *cursor, u32 keyframe_index) {
+    Replay_Keyframe *keyframe = &replay->keyframes[keyframe_index];
+    *cursor = {};
+    cursor->at = replay->data + keyframe->offset + sizeof(Snapshot);
+    cursor->end = ((keyframe_index + 1 < replay->header.keyframe_count) ?
+                   replay->data + replay->keyframes[keyframe_index + 1].offset :
+                   replay->data + replay->header.index_offset);
+    cursor->keyframe_index = keyframe_index;
+    cursor->step_index = keyframe->step_index;
+    cursor->chunk_end_step_index = keyframe->step_index + replay->header.keyframe_interval;
+    if (cursor->chunk_end_step_index > replay->header.step_count)  cursor->chunk_end_step_index = replay->header.step_count;
+}
+
+// @note The next step, false after the last one or if the steps are damaged, then cursor->step_index is not
+//       header.step_count. Does not look at the keyframes, a chunk is entered with the state its steps left.
+internal b32
+next_replay_step(Replay *replay, Replay_Cursor *cursor, Replay_Step *step) {
+    if (cursor->run_remaining == 0) {
+        if (cursor->step_index == cursor->chunk_end_step_index) {
+            // @note a chunk has to end with its last step
+            if (cursor->at != cursor->end || cursor->keyframe_index + 1 >= replay->header.keyframe_count)  return false;
+            begin_replay_chunk(replay, cursor, cursor->keyframe_index + 1);
+        }
+        if (!decode_replay_run(&cursor->at, cursor->end, &cursor->step, &cursor->run_remaining))  return false;
+        if (cursor->run_remaining > cursor->chunk_end_step_index - cursor->step_index)  return false;
+    }
+    *step = cursor->step;
+    --cursor->run_remaining;
+    ++cursor->step_index;
+    return true;
+}
+
+// @note runs the whole replay from init_game, true if every keyframe and the final state match the recording
+internal b32
+play_replay(Replay *replay, Game_State *game_state) {
+    init_game(game_state, replay->header.seed, replay->header.tick_hz, replay->header.instant_gravity);
+    if (replay->header.keyframe_count == 0) {
+        return (game_state->tick_count == replay->header.final_tick_count &&
+                get_game_state_checksum(game_state) == replay->header.final_checksum);
+    }
+    
+    Replay_Cursor cursor;
+    begin_replay_chunk(replay, &cursor, 0);
+    for (;;) {
+        if ((cursor.step_index % replay->header.keyframe_interval) == 0 && cursor.step_index < replay->header.step_count) {
+            Snapshot keyframe, saved;
+            get_replay_keyframe(replay, (u32)(cursor.step_index / replay->header.keyframe_interval), &keyframe);
+            save_snapshot(game_state, &saved);
+            if (memcmp(&keyframe, &saved, sizeof(saved)) != 0)  return false;
+        }
+        Replay_Step step;
+        if (!next_replay_step(replay, &cursor, &step))  break;
+        Game_Controller_Input controller = decode_replay_step(&step);
+        game_step(game_state, &controller, step.ticks);
+    }
+    b32 result = (cursor.step_index == replay->header.step_count &&
+                  game_state->tick_count == replay->header.final_tick_count &&
+                  get_game_state_checksum(game_state) == replay->header.final_checksum);
+    return result;
+}
+
+// @note The state before step step_index, header.step_count for the final state. Restores the keyframe before
+//       it and simulates the rest of the way, false if the replay is damaged on the way.
+internal b32
+seek_replay(Replay *replay, u64 step_index, Game_State *game_state) {
+    TIMED_BLOCK("seek replay");
+    if (step_index > replay->header.step_count)  return false;
+    if (replay->header.keyframe_count == 0) {
+        init_game(game_state, replay->header.seed, replay->header.tick_hz, replay->header.instant_gravity);
+        return true;
+    }
+    
+    u64 keyframe_index = step_index / replay->header.keyframe_interval;
+    if (keyframe_index >= replay->header.keyframe_count)  keyframe_index = replay->header.keyframe_count - 1;
+    Snapshot keyframe;
+    get_replay_keyframe(replay, (u32)keyframe_index, &keyframe);
+    if (!load_snapshot(&keyframe, game_state))  return false;
+    
+    Replay_Cursor cursor;
+    begin_replay_chunk(replay, &cursor, (u32)keyframe_index);
+    while (cursor.step_index < step_index) {
+        Replay_Step step;
+        if (!next_replay_step(replay, &cursor, &step))  return false;
+        Game_Controller_Input controller = decode_replay_step(&step);
+        game_step(game_state, &controller, step.ticks);
+    }
+    return true;
+}
+
+
+#define TETRIS_REPLAY_H
+#endif
@@ -0,0 +1,105 @@
+#if !defined(TETRIS_REWIND_H)
+
+// @note Rewind history for the live game. A ring of chunks in memory the platform layer hands over once,
+//       each chunk being a Snapshot keyframe of the state before its first step and the Replay_Steps that
+//       follow. Going back to any step restores that chunk's keyframe and simulates the steps up to it, at most
+//       keyframe_interval - 1. Once the ring is full the oldest chunk is dropped, the memory budget is how far
+//       back rewinding reaches. Nothing is allocated while playing.
+//       Needs tetris_snapshot.h and tetris_replay.h.
+
+
+#define REWIND_KEYFRAME_INTERVAL 64 // @note steps per chunk, a rewind simulates less than this many
+
+struct Rewind_Buffer {
+    u32 keyframe_interval;
+    u32 chunk_capacity;
+    Snapshot *keyframes; // @note chunk_capacity, chunk c in slot c % chunk_capacity
+    Replay_Step *steps;  // @note chunk_capacity * keyframe_interval
+    
+    u64 first_step_index; // @note the oldest step still in the ring, always the first of a chunk
+    u64 step_count;       // @note steps recorded, the game state is the one after the last of them
+};
+
+inline u64
+get_rewind_chunk_size(u32 keyframe_interval) {
+    u64 result = sizeof(Snapshot) + (u64)keyframe_interval * sizeof(Replay_Step);
+    return result;
+}
+
+// @note Lays out the ring in memory, false if memory_size does not hold a single chunk. memory has to be aligned
+//       for u64 and stays in use until the buffer is not used anymore.
+internal b32
+init_rewind_buffer(Rewind_Buffer *rewind, void *memory, u64 memory_size, u32 keyframe_interval = REWIND_KEYFRAME_INTERVAL) {
+    *rewind = {};
+    if (!memory || keyframe_interval == 0)  return false;
+    u64 chunk_capacity = memory_size / get_rewind_chunk_size(keyframe_interval);
+    if (chunk_capacity == 0)  return false;
+    if (chunk_capacity > 0xFFFFFFFF)  chunk_capacity = 0xFFFFFFFF;
+    
+    rewind->keyframe_interval = keyframe_interval;
+    rewind->chunk_capacity = (u32)chunk_capacity;
+    rewind->keyframes = (Snapshot *)memory;
+    rewind->steps = (Replay_Step *)(rewind->keyframes + chunk_capacity);
+    return true;
+}
+
+// @note forgets the history, e.g. when the game is replaced by a loaded one
+inline void
+clear_rewind_buffer(Rewind_Buffer *rewind) {
+    rewind->first_step_index = 0;
+    rewind->step_count = 0;
+}
+
+// @note call with exactly what was passed to game_step and the state before it, steps without ticks are skipped
+internal void
+record_rewind_step(Rewind_Buffer *rewind, Game_State *game_state, const Game_Controller_Input *controller, u32 ticks) {
+    if (!rewind->chunk_capacity || ticks == 0)  return;
+    u64 chunk_index = rewind->step_count / rewind->keyframe_interval;
+    u64 slot = chunk_index % rewind->chunk_capacity;
+    u32 step_in_chunk = (u32)(rewind->step_count % rewind->keyframe_interval);
+    if (step_in_chunk == 0) {
+        save_snapshot(game_state, &rewind->keyframes[slot]);
+        // @note the slot's old chunk is gone, after a rewind that can be a later one than the oldest and the
+        //       chunks in between were overwritten before, so the first step only ever moves forward
+        if (chunk_index >= rewind->chunk_capacity) {
+            u64 first_step_index = (chunk_index - rewind->chunk_capacity + 1) * rewind->keyframe_interval;
+            if (first_step_index > rewind->first_step_index)  rewind->first_step_index = first_step_index;
+        }
+    }
+    rewind->steps[slot * rewind->keyframe_interval + step_in_chunk] = encode_replay_step(controller, ticks);
+    ++rewind->step_count;
+}
+
+// @note True if step_index can still be rewound to, the current state at step_count included
+inline b32
+can_rewind_to_step(Rewind_Buffer *rewind, u64 step_index) {
+    b32 result = (rewind->step_count > 0 && step_index >= rewind->first_step_index && step_index <= rewind->step_count);
+    return result;
+}
+
+// @note Puts game_state back to before step step_index and drops the steps after it, recording goes on from
+//       there. False if the step is no longer in the ring, game_state is unchanged then.
+internal b32
+rewind_to_step(Rewind_Buffer *rewind, u64 step_index, Game_State *game_state) {
+    TIMED_BLOCK("rewind");
+    if (!can_rewind_to_step(rewind, step_index))  return false;
+    if (step_index == rewind->step_count)  return true;
+    
+    u64 chunk_index = step_index / rewind->keyframe_interval;
+    u64 slot = chunk_index % rewind->chunk_capacity;
+    Game_State rewound;
+    if (!load_snapshot(&rewind->keyframes[slot], &rewound))  return false;
+    Replay_Step *steps = rewind->steps + slot * rewind->keyframe_interval;
+    u32 step_count = (u32)(step_index % rewind->keyframe_interval);
+    for (u32 i = 0; i < step_count; ++i) {
+        Game_Controller_Input controller = decode_replay_step(&steps[i]);
+        game_step(&rewound, &controller, steps[i].ticks);
+    }
+    *game_state = rewound;
+    rewind->step_count = step_index;
+    return true;
+}
+
+
+#define TETRIS_REWIND_H
+#endif
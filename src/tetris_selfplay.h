@@ -0,0 +1,215 @@
+#if !defined(TETRIS_SELFPLAY_H)
+
+// @note Batch self-play for evaluating placement policies, one complete game per seed on all cores.
+//       The platform layer creates the threads and calls run_selfplay_worker on each of them.
+//       Work stealing: every worker starts with an even share of the games and when it runs out it steals
+//       half of the games another worker has left, so long and short games balance out across the workers.
+//       Each worker owns its Game_State, placement list and statistics, padded to their own cache lines.
+//       A game only depends on its seed, the results are the same for any worker count.
+
+
+#define MAX_SELFPLAY_WORKERS 64
+#define SELFPLAY_CACHE_LINE_SIZE 64
+
+// @note returns the index of the placement to lock, series is seeded per game so policies can be random and still deterministic
+#define SELFPLAY_POLICY_SIG(name) int name(Game_State *game_state, Placement_List *placements, Random_Series *series, void *user_data)
+typedef SELFPLAY_POLICY_SIG(Selfplay_Policy_Sig);
+
+struct Selfplay_Game_Result {
+    u32 pieces; // @note locked pieces, the game ends when the next one can not spawn or at max_pieces_per_game
+    u32 lines;
+    u64 score;
+};
+
+struct Selfplay_Stats {
+    u64 game_count;
+    u64 pieces;
+    u64 lines;
+    u64 score;
+    u64 max_pieces;
+    u64 capped_game_count; // @note games stopped at max_pieces_per_game
+    u64 steal_count;
+};
+
+struct alignas(SELFPLAY_CACHE_LINE_SIZE) Selfplay_Worker {
+    // @note next game index in the low 32 bits and the end in the high 32 bits, other workers steal from the end.
+    //       Only ever changed with a compare exchange, alone on its cache line since every thief touches it.
+    volatile u64 range;
+    u8 range_padding[SELFPLAY_CACHE_LINE_SIZE - sizeof(u64)];
+    
+    Game_State game_state;
+    Placement_List placements;
+    Selfplay_Stats stats;
+};
+
+struct Selfplay_Batch {
+    u64 first_seed; // @note game i plays seed first_seed + i
+    u32 game_count;
+    u32 worker_count;
+    u32 max_pieces_per_game;
+    Selfplay_Policy_Sig *policy;
+    void *policy_data;
+    Selfplay_Game_Result *results; // @note optional, game_count entries
+    
+    Selfplay_Worker workers[MAX_SELFPLAY_WORKERS];
+};
+
+inline u64
+make_selfplay_range(u32 begin, u32 end) {
+    u64 result = ((u64)end << 32) | (u64)begin;
+    return result;
+}
+
+internal void
+init_selfplay_batch(Selfplay_Batch *batch, u64 first_seed, u32 game_count, u32 worker_count, u32 max_pieces_per_game,
+                    Selfplay_Policy_Sig *policy, void *policy_data, Selfplay_Game_Result *results) {
+    assert(worker_count > 0 && worker_count <= MAX_SELFPLAY_WORKERS);
+    batch->first_seed = first_seed;
+    batch->game_count = game_count;
+    batch->worker_count = worker_count;
+    batch->max_pieces_per_game = max_pieces_per_game;
+    batch->policy = policy;
+    batch->policy_data = policy_data;
+    batch->results = results;
+    for (u32 worker_index = 0; worker_index < worker_count; ++worker_index) {
+        Selfplay_Worker *worker = &batch->workers[worker_index];
+        u32 begin = (u32)(((u64)game_count * worker_index) / worker_count);
+        u32 end = (u32)(((u64)game_count * (worker_index + 1)) / worker_count);
+        worker->range = make_selfplay_range(begin, end);
+        worker->stats = {};
+    }
+}
+
+// @note the owner takes games from the front of its own range
+internal b32
+take_selfplay_game(Selfplay_Worker *worker, u32 *game_index) {
+    for (;;) {
+        u64 range = atomic_load_acquire_u64(&worker->range);
+        u32 begin = (u32)range;
+        u32 end = (u32)(range >> 32);
+        if (begin >= end)  return false;
+        if (atomic_compare_exchange_u64(&worker->range, range, make_selfplay_range(begin + 1, end)) == range) {
+            *game_index = begin;
+            return true;
+        }
+    }
+}
+
+// @note Takes the back half of the first other worker's range that still has games, starting at the next worker.
+//       Only called with an empty own range, no other thread changes an empty range so a plain store is enough.
+internal b32
+steal_selfplay_games(Selfplay_Batch *batch, u32 worker_index) {
+    for (u32 offset = 1; offset < batch->worker_count; ++offset) {
+        Selfplay_Worker *victim = &batch->workers[(worker_index + offset) % batch->worker_count];
+        for (;;) {
+            u64 range = atomic_load_acquire_u64(&victim->range);
+            u32 begin = (u32)range;
+            u32 end = (u32)(range >> 32);
+            if (begin >= end)  break;
+            
+            u32 steal_count = (end - begin + 1) / 2;
+            if (atomic_compare_exchange_u64(&victim->range, range, make_selfplay_range(begin, end - steal_count)) == range) {
+                Selfplay_Worker *worker = &batch->workers[worker_index];
+                atomic_store_release_u64(&worker->range, make_selfplay_range(end - steal_count, end));
+                ++worker->stats.steal_count;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+internal void
+play_selfplay_game(Selfplay_Batch *batch, Selfplay_Worker *worker, u32 game_index) {
+    u64 seed = batch->first_seed + game_index;
+    Game_State *game_state = &worker->game_state;
+    init_game(game_state, seed);
+    Random_Series series = random_seed(seed, 0x5E1F9A7ULL);
+    
+    Selfplay_Game_Result result = {};
+    while (game_state->game_over_count == 0) {
+        if (result.pieces >= batch->max_pieces_per_game) {
+            ++worker->stats.capped_game_count;
+            break;
+        }
+        int count = enumerate_placements(game_state, game_state->current_block.type, &worker->placements);
+        if (count == 0)  break;
+        int choice = batch->policy(game_state, &worker->placements, &series, batch->policy_data);
+        assert(choice >= 0 && choice < count);
+        
+        Line_Clear_Result cleared = lock_placement(game_state, &worker->placements.placements[choice]);
+        ++result.pieces;
+        result.lines += cleared.count;
+        result.score += line_clear_score[cleared.count];
+    }
+    
+    Selfplay_Stats *stats = &worker->stats;
+    ++stats->game_count;
+    stats->pieces += result.pieces;
+    stats->lines += result.lines;
+    stats->score += result.score;
+    if (result.pieces > stats->max_pieces)  stats->max_pieces = result.pieces;
+    if (batch->results)  batch->results[game_index] = result;
+}
+
+// @note thread entry, returns when no worker has games left
+internal void
+run_selfplay_worker(Selfplay_Batch *batch, u32 worker_index) {
+    Selfplay_Worker *worker = &batch->workers[worker_index];
+    for (;;) {
+        u32 game_index;
+        if (take_selfplay_game(worker, &game_index)) {
+            play_selfplay_game(batch, worker, game_index);
+        }
+        else if (!steal_selfplay_games(batch, worker_index)) {
+            break;
+        }
+    }
+}
+
+// @note call after all workers returned
+internal Selfplay_Stats
+get_selfplay_stats(Selfplay_Batch *batch) {
+    Selfplay_Stats result = {};
+    for (u32 worker_index = 0; worker_index < batch->worker_count; ++worker_index) {
+        Selfplay_Stats *stats = &batch->workers[worker_index].stats;
+        result.game_count += stats->game_count;
+        result.pieces += stats->pieces;
+        result.lines += stats->lines;
+        result.score += stats->score;
+        if (stats->max_pieces > result.max_pieces)  result.max_pieces = stats->max_pieces;
+        result.capped_game_count += stats->capped_game_count;
+        result.steal_count += stats->steal_count;
+    }
+    return result;
+}
+
+
+//
+// @note policies
+//
+
+internal
+SELFPLAY_POLICY_SIG(selfplay_policy_random) {
+    int result = (int)random_choice(series, (u32)placements->count);
+    return result;
+}
+
+// @note greedy, the best placement by evaluate_placement, rarely loses so use it with max_pieces_per_game
+internal
+SELFPLAY_POLICY_SIG(selfplay_policy_heuristic) {
+    int result = 0;
+    f32 best_value = 0;
+    for (int i = 0; i < placements->count; ++i) {
+        f32 value = evaluate_placement(&placements->placements[i]);
+        if (i == 0 || value > best_value) {
+            best_value = value;
+            result = i;
+        }
+    }
+    return result;
+}
+
+
+#define TETRIS_SELFPLAY_H
+#endif
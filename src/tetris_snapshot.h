@@ -0,0 +1,229 @@
+#if !defined(TETRIS_SNAPSHOT_H)
+
+// @note Game_State snapshots for save games and for checkpointing positions in bulk. A Snapshot is a fixed size
+//       record of everything that influences future simulation: the color plane packed to 3 bits per cell, the
+//       blocks as type, rotation and origin, the generator and the counters. The occupancy, the board caches and
+//       the block minos follow from those and are rebuilt on load.
+//       A snapshot file is a header and an array of Snapshots written as they are in memory, little endian.
+//       Mapped into memory the records can be used in place (see get_snapshot_records), there is nothing to parse.
+//       Needs stdio.h from the platform layer.
+
+
+#define SNAPSHOT_MAGIC 0x50534E54 // @note "TNSP"
+#define SNAPSHOT_VERSION 1
+
+#define SNAPSHOT_CELL_BITS 3
+#define SNAPSHOT_CELL_MASK ((1 << SNAPSHOT_CELL_BITS) - 1)
+
+#define SNAPSHOT_INSTANT_GRAVITY (1 << 0)
+
+struct Snapshot_Block {
+    u8 type;
+    u8 rotation;
+    s8 x; // @note origin
+    s8 y;
+};
+
+struct Snapshot {
+    u64 seed;
+    u64 score;
+    u64 random_state;
+    u64 random_increment;
+    u64 tick_count;
+    u64 pieces_spawned;
+    u64 lines_cleared;
+    u64 game_over_count;
+    u64 packed_queue; // @note the generator's whole ring, 3 bits per Block_Type, stale entries are part of the checksum
+    u32 packed_rows[GRID_HEIGHT]; // @note the color plane, cell x of a row at bit SNAPSHOT_CELL_BITS * x
+    Snapshot_Block current_block;
+    Snapshot_Block previous_block;
+    u16 tick_hz;
+    u16 gravity_interval_ticks;
+    u16 gravity_tick_counter;
+    u8 queue_read;
+    u8 queue_count;
+    u8 flags; // @note SNAPSHOT_*
+    u8 reserved[7];
+};
+
+typedef bool __check_snapshot_size__[sizeof(Snapshot) == 176 ? 1 : -1];
+typedef bool __check_snapshot_cell_bits__[(Block_Type::ENUM_SIZE <= (1 << SNAPSHOT_CELL_BITS)) ? 1 : -1];
+typedef bool __check_snapshot_row_bits__[(GRID_WIDTH * SNAPSHOT_CELL_BITS <= 32) ? 1 : -1];
+typedef bool __check_snapshot_queue_bits__[(PIECE_QUEUE_SIZE * SNAPSHOT_CELL_BITS <= 64) ? 1 : -1];
+typedef bool __check_snapshot_tick_hz__[(MAX_TICK_HZ <= 0xFFFF) ? 1 : -1];
+
+// @note records start right after the header, which keeps them 8 byte aligned in a mapped file
+struct Snapshot_File_Header {
+    u32 magic;
+    u32 version;
+    u32 record_size; // @note sizeof(Snapshot), to reject files from a different layout
+    u32 reserved;
+    u64 record_count;
+};
+
+typedef bool __check_snapshot_file_header_size__[(sizeof(Snapshot_File_Header) % 8) == 0 ? 1 : -1];
+
+inline Snapshot_Block
+pack_snapshot_block(Block *block) {
+    Snapshot_Block result;
+    result.type = (u8)block->type;
+    result.rotation = (u8)block->rotation;
+    result.x = (s8)block->origin.x;
+    result.y = (s8)block->origin.y;
+    return result;
+}
+
+inline Block
+unpack_snapshot_block(Snapshot_Block *packed) {
+    Block result = {};
+    result.type = packed->type;
+    set_block_placement(&result, packed->x, packed->y, packed->rotation);
+    return result;
+}
+
+internal void
+save_snapshot(Game_State *game_state, Snapshot *snapshot) {
+    TIMED_BLOCK("save snapshot");
+    *snapshot = {};
+    snapshot->seed = game_state->seed;
+    snapshot->score = game_state->score;
+    snapshot->tick_count = game_state->tick_count;
+    snapshot->pieces_spawned = game_state->pieces_spawned;
+    snapshot->lines_cleared = game_state->lines_cleared;
+    snapshot->game_over_count = game_state->game_over_count;
+    
+    Piece_Generator *generator = &game_state->piece_generator;
+    snapshot->random_state = generator->series.state;
+    snapshot->random_increment = generator->series.increment;
+    for (int i = 0; i < PIECE_QUEUE_SIZE; ++i) {
+        snapshot->packed_queue |= (u64)generator->queue[i] << (SNAPSHOT_CELL_BITS * i);
+    }
+    snapshot->queue_read = (u8)generator->queue_read;
+    snapshot->queue_count = (u8)generator->queue_count;
+    
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        u32 packed = 0;
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            packed |= (u32)game_state->grid[y][x] << (SNAPSHOT_CELL_BITS * x);
+        }
+        snapshot->packed_rows[y] = packed;
+    }
+    snapshot->current_block = pack_snapshot_block(&game_state->current_block);
+    snapshot->previous_block = pack_snapshot_block(&game_state->previous_block);
+    
+    snapshot->tick_hz = (u16)game_state->tick_hz;
+    snapshot->gravity_interval_ticks = (u16)game_state->gravity_interval_ticks;
+    snapshot->gravity_tick_counter = (u16)game_state->gravity_tick_counter;
+    if (game_state->instant_gravity)  snapshot->flags |= SNAPSHOT_INSTANT_GRAVITY;
+}
+
+// @note A restored game has the same checksum as the saved one and continues exactly like it. Returns false if
+//       the snapshot can not be a game state, e.g. from a damaged file, game_state is garbage then.
+internal b32
+load_snapshot(Snapshot *snapshot, Game_State *game_state) {
+    TIMED_BLOCK("load snapshot");
+    if (snapshot->tick_hz == 0 || snapshot->tick_hz > MAX_TICK_HZ || snapshot->gravity_interval_ticks == 0)  return false;
+    // @note next_piece needs more than the previews queued, and every queued piece has to be able to spawn
+    if (snapshot->queue_read >= PIECE_QUEUE_SIZE || snapshot->queue_count <= PREVIEW_COUNT || snapshot->queue_count > PIECE_QUEUE_SIZE)  return false;
+    for (u32 i = 0; i < snapshot->queue_count; ++i) {
+        u32 queue_index = (snapshot->queue_read + i) & (PIECE_QUEUE_SIZE - 1);
+        u32 type = (u32)(snapshot->packed_queue >> (SNAPSHOT_CELL_BITS * queue_index)) & SNAPSHOT_CELL_MASK;
+        if (type == Block_Type::EMPTY || type >= Block_Type::ENUM_SIZE)  return false;
+    }
+    Snapshot_Block *blocks[] = { &snapshot->current_block, &snapshot->previous_block };
+    for (int i = 0; i < (int)array_count(blocks); ++i) {
+        if (blocks[i]->type == Block_Type::EMPTY || blocks[i]->type >= Block_Type::ENUM_SIZE || blocks[i]->rotation > 3)  return false;
+    }
+    
+    *game_state = {};
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        u32 packed = snapshot->packed_rows[y];
+        u16 row = 0;
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            int type = (int)((packed >> (SNAPSHOT_CELL_BITS * x)) & SNAPSHOT_CELL_MASK);
+            game_state->grid[y][x] = type;
+            if (type != Block_Type::EMPTY)  row |= (u16)(1 << x);
+        }
+        game_state->rows[y] = row;
+    }
+    rebuild_board_cache(game_state);
+    
+    // @note the current_block never overlaps the grid, the previous_block can overlap cells locked since
+    Snapshot_Block *current = &snapshot->current_block;
+    if (!does_piece_fit(game_state, current->type, current->rotation, current->x, current->y))  return false;
+    game_state->current_block = unpack_snapshot_block(current);
+    game_state->previous_block = unpack_snapshot_block(&snapshot->previous_block);
+    if (is_block_out_of_bounds(&game_state->previous_block))  return false;
+    
+    game_state->seed = snapshot->seed;
+    game_state->score = snapshot->score;
+    game_state->tick_count = snapshot->tick_count;
+    game_state->pieces_spawned = snapshot->pieces_spawned;
+    game_state->lines_cleared = snapshot->lines_cleared;
+    game_state->game_over_count = snapshot->game_over_count;
+    game_state->tick_hz = snapshot->tick_hz;
+    game_state->gravity_interval_ticks = snapshot->gravity_interval_ticks;
+    game_state->gravity_tick_counter = snapshot->gravity_tick_counter;
+    game_state->instant_gravity = (snapshot->flags & SNAPSHOT_INSTANT_GRAVITY) != 0;
+    
+    Piece_Generator *generator = &game_state->piece_generator;
+    generator->series.state = snapshot->random_state;
+    generator->series.increment = snapshot->random_increment;
+    for (int i = 0; i < PIECE_QUEUE_SIZE; ++i) {
+        generator->queue[i] = (u8)((snapshot->packed_queue >> (SNAPSHOT_CELL_BITS * i)) & SNAPSHOT_CELL_MASK);
+    }
+    generator->queue_read = snapshot->queue_read;
+    generator->queue_count = snapshot->queue_count;
+    return true;
+}
+
+
+//
+// @note files
+//
+
+internal b32
+write_snapshot_file(FILE *file, Snapshot *snapshots, u64 count) {
+    if (!file)  return false;
+    Snapshot_File_Header header = {};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.record_size = sizeof(Snapshot);
+    header.record_count = count;
+    b32 result = (fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(snapshots, sizeof(Snapshot), (size_t)count, file) == (size_t)count);
+    return result;
+}
+
+// @note The records of a snapshot file that is already in memory, e.g. mapped by the platform layer, 0 if the
+//       memory does not hold a complete snapshot file of this version. The records are not copied or checked.
+internal Snapshot *
+get_snapshot_records(void *memory, u64 size, u64 *count) {
+    *count = 0;
+    if (!memory || size < sizeof(Snapshot_File_Header))  return 0;
+    Snapshot_File_Header *header = (Snapshot_File_Header *)memory;
+    if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION || header->record_size != sizeof(Snapshot))  return 0;
+    if (header->record_count > (size - sizeof(Snapshot_File_Header)) / sizeof(Snapshot))  return 0;
+    
+    *count = header->record_count;
+    Snapshot *result = (Snapshot *)((u8 *)memory + sizeof(Snapshot_File_Header));
+    return result;
+}
+
+// @note the first record of a file, for save games
+internal b32
+read_snapshot_file(FILE *file, Snapshot *snapshot) {
+    if (!file)  return false;
+    Snapshot_File_Header header;
+    if (fread(&header, sizeof(header), 1, file) != 1)  return false;
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION || header.record_size != sizeof(Snapshot) ||
+        header.record_count == 0) {
+        return false;
+    }
+    b32 result = (fread(snapshot, sizeof(*snapshot), 1, file) == 1);
+    return result;
+}
+
+
+#define TETRIS_SNAPSHOT_H
+#endif
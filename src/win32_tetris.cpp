@@ -1,6 +1,3 @@
-// @todo improve input system
-
-
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <mmsystem.h> // @note excluded in lean and mean, used for timeBeginPeriod to set scheduler granularity
@@ -8,25 +5,31 @@
 #include <xinput.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 
-#include "iml_general.h"
-#include "iml_types.h"
+#include "tetris.cpp"
+#include "tetris_render.cpp"
+#include "tetris_placement.cpp"
+#include "tetris_frame.h"
+#include "tetris_frame_log.h"
+#include "tetris_input_queue.h"
+#include "tetris_snapshot.h"
+#include "tetris_replay.h"
+#include "tetris_rewind.h"
+#include "tetris_pathfinder.h"
+#include "tetris_planner.h"
 
 
 #define SCALE_FACTOR 6
 
-#define BLOCK_SIZE 7
-
-#define BLOCK_GAP_SIZE 1
-
-#define GRID_WIDTH 10
-#define GRID_HEIGHT 20
-#define WIDTH  ((GRID_WIDTH * BLOCK_SIZE) + ((GRID_WIDTH+1) * BLOCK_GAP_SIZE))
-#define HEIGHT ((GRID_HEIGHT * BLOCK_SIZE) + ((GRID_HEIGHT+1) * BLOCK_GAP_SIZE))
-
 #define WINDOW_WIDTH (WIDTH * SCALE_FACTOR)
 #define WINDOW_HEIGHT (HEIGHT * SCALE_FACTOR)
 
+// @note windows 10 1803+, older versions fail CreateWaitableTimerExW with this flag
+#if !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
 
 struct Win32_Offscreen_Buffer {
     BITMAPINFO info;
@@ -42,123 +45,53 @@ struct Win32_Window_Dimension {
     int height;
 };
 
-struct Vector2 {
-    int x;
-    int y;
-};
-typedef Vector2 v2;
-
-struct Vector3 {
-    union {
-        struct {
-            u32 x;
-            u32 y;
-            u32 z;
-        };
-        struct {
-            u32 r;
-            u32 g;
-            u32 b;
-        };
-    };
-};
-typedef Vector3 v3;
-
-internal Vector3
-rgb(u32 r, u32 g, u32 b) {
-    Vector3 rgb { r, g, b };
-    return rgb;
-}
-
-enum Block_Type {
-    EMPTY = 0,
-    
-    // @note descriptions from wikipedia:https://tetris.wiki/Tetromino
-    I, // Light blue; shaped like a capital I; four Minos in a straight line. Other names include straight, stick, and long. This is the only tetromino that can clear four lines outside of cascade games.
-    O, // Yellow; a square shape; four Minos in a 2×2 square. Other names include square and block.
-    T, // Purple; shaped like a capital T; a row of three Minos with one added above the center.
-    S, // Green; shaped like a capital S; two stacked horizontal diminos with the top one offset to the right. Other names include inverse skew and right snake.
-    Z, // Red; shaped like a capital Z; two stacked horizontal diminos with the top one offset to the left. Other names include skew and left snake.
-    J, // Blue; shaped like a capital J; a row of three Minos with one added above the left side. Other names include gamma, inverse L, or left gun.
-    L, // Orange; shaped like a capital L; a row of three Minos with one added above the right side. Other names include right gun.
-    
-    ENUM_SIZE,
-};
-
-struct Block {
-    Vector2 pos[4];
-    enum32(Block_Type) type;
-};
-
-struct Game_State {
-    Block current_block;
-    int grid[GRID_HEIGHT][GRID_WIDTH]; // @todo enum for the color of the block
-};
-
-struct Game_Button_State {
-    b32 ended_down;
-    b32 allow_press;
-    int half_transition_count;
-};
-
-struct Game_Controller_Input {
+global Win32_Offscreen_Buffer global_backbuffer;
+global b32 global_running;
+global s64 global_performance_count_frequency;
+global WINDOWPLACEMENT global_window_position = { sizeof(global_window_position) };
+global HANDLE global_frame_timer;
+global Frame_Log global_frame_log;
+global b32 global_write_frame_log; // @note F9, written at exit too
+global b32 global_show_debug_overlay; // @note F10, only with TETRIS_PROFILE
+global b32 global_bot_enabled; // @note F8, the bot plays instead of the active controller
+global b32 global_save_snapshot; // @note F5, to session.tetris_snapshot
+global b32 global_load_snapshot; // @note F6
+global u64 global_start_cycle_count;
+global f64 global_start_seconds;
+
+// @note XInputGetState on an empty slot is slow, so a disconnected slot is probed again after an interval that
+//       doubles up to XINPUT_MAX_PROBE_SECONDS. WM_DEVICECHANGE probes every slot on the next poll.
+#define XINPUT_MIN_PROBE_SECONDS 0.25
+#define XINPUT_MAX_PROBE_SECONDS 2.0
+
+struct Win32_XInput_Slot {
     b32 is_connected;
-    b32 is_analog;
-    f32 stick_average_x;
-    f32 stick_average_y;
-    
-    union {
-        Game_Button_State buttons[12];
-        
-        struct {
-            Game_Button_State move_up;
-            Game_Button_State move_down;
-            Game_Button_State move_left;
-            Game_Button_State move_right;
-            
-            Game_Button_State action_up;
-            Game_Button_State action_down;
-            Game_Button_State action_left;
-            Game_Button_State action_right;
-            
-            Game_Button_State left_shoulder;
-            Game_Button_State right_shoulder;
-            
-            Game_Button_State start;
-            Game_Button_State back;
-            
-            // @note all buttons must be added to the struct above this line!!!
-            Game_Button_State _terminator_;
-        };
-    };
+    f64 next_probe_seconds;
+    f64 probe_interval;
 };
 
-struct Game_Input {
-    Game_Controller_Input controllers[5];
+// @note How often the input thread polls XInput, keyboard input wakes it right away. Relies on the 1ms
+//       scheduler granularity from timeBeginPeriod.
+#define WIN32_INPUT_POLL_MS 1
+
+// @note The producer side of the input queue, controller 0 is the keyboard and the XInput slots follow. Owned
+//       by the input thread, or by the main thread if the input thread could not be started.
+struct Win32_Input_Producer {
+    Input_Queue *queue;
+    HWND game_window; // @note key presses only count while it is in the foreground
+    HANDLE ready_event;
+    b32 has_raw_keyboard;
+    u32 button_bits[1 + XUSER_MAX_COUNT]; // @note a bit per button index, as last pushed
+    Win32_XInput_Slot xinput_slots[XUSER_MAX_COUNT];
 };
 
-inline Game_Controller_Input *
-get_controller(Game_Input *input, u32 controller_index) {
-    assert(controller_index < array_count(input->controllers));
-    return &input->controllers[controller_index];
-}
-
-
-global Vector3 block_colors_by_type[Block_Type::ENUM_SIZE] = {
-    rgb(255,255,255), // Block_Type::EMPTY, should not get rendered
-    
-    rgb(  0, 191, 255),
-    rgb(255, 255, 0  ),
-    rgb(128,   0, 128),
-    rgb(  0, 255, 0  ),
-    rgb(255,   0, 0  ),
-    rgb(  0,   0, 255),
-    rgb(255, 165, 0  )
-};
-global Win32_Offscreen_Buffer global_backbuffer;
-global b32 global_running;
-global s64 global_performance_count_frequency;
-global WINDOWPLACEMENT global_window_position = { sizeof(global_window_position) };
+global Input_Queue global_input_queue;
+global Input_Tracker global_input_tracker; // @note the consumer side, only touched by the main thread
+global Win32_Input_Producer global_input_producer;
+global HANDLE global_input_thread;
+global volatile b32 global_input_thread_running;
+global f64 global_input_event_latency_sum; // @note from each event's timestamp to the present of the frame that took it
+global volatile u32 global_xinput_devices_changed; // @note set on the main thread, taken by the producer
 
 
 // @note xinput_get_state
@@ -203,123 +136,6 @@ win32_load_xinput() {
 }
 
 
-internal b32
-is_block_colliding(Game_State *game_state, Block *block) {
-    b32 hit = false;
-    for (int i = 0; i < 4; ++i) {
-        if (game_state->grid[block->pos[i].y][block->pos[i].x] != Block_Type::EMPTY)  {
-            hit = true;
-            break;
-        }
-    }
-    return hit;
-}
-
-internal b32
-is_block_out_of_bounds(Block *block) {
-    b32 out_of_bounds = false;
-    for (int i = 0; i < 4; ++i) {
-        if ((block->pos[i].y >= 0            &&
-             block->pos[i].y <  GRID_HEIGHT) &&
-            (block->pos[i].x >= 0            &&
-             block->pos[i].x <  GRID_WIDTH)) {
-            // inside grid
-        }
-        else {
-            out_of_bounds = true;
-            break;
-        }
-    }
-    return out_of_bounds;
-}
-
-internal void
-rotate_block(Block *block, b32 clockwise) {
-    Vector2 rotating_pos;
-    if (block->type == Block_Type::I)  rotating_pos = block->pos[1];
-    else if (block->type == Block_Type::O)  return;
-    else if (block->type == Block_Type::T)  rotating_pos = block->pos[2];
-    else if (block->type == Block_Type::S)  rotating_pos = block->pos[1];
-    else if (block->type == Block_Type::S)  rotating_pos = block->pos[1];
-    else if (block->type == Block_Type::J)  rotating_pos = block->pos[2];
-    else if (block->type == Block_Type::J)  rotating_pos = block->pos[2];
-    else rotating_pos = block->pos[1];
-    
-    for (int i = 0; i < 4; ++i) {
-        Vector2 diff;
-        diff.x = rotating_pos.x - block->pos[i].x;
-        diff.y = rotating_pos.y - block->pos[i].y;
-        
-        if (clockwise) {
-            block->pos[i].x = rotating_pos.x + diff.y;
-            block->pos[i].y = rotating_pos.y - diff.x;
-        }
-        else {
-            block->pos[i].x = rotating_pos.x - diff.y;
-            block->pos[i].y = rotating_pos.y + diff.x;
-        }
-    }
-}
-
-#include <stdlib.h>
-#include <time.h>
-
-internal u32
-get_random_number_in_range(int min, int max) {
-    srand(time(null));
-    u32 random = min + (rand() % ((max + 1) - min));
-    return random;
-}
-
-internal void reset_game(Game_State *game_state, b32 clear_grid);
-internal void
-make_new_current_block(Game_State *game_state) {
-    // @todo generate different rotations?
-    
-    int min = Block_Type::EMPTY + 1;
-    int max = Block_Type::ENUM_SIZE - 1;
-    enum32(Block_Type) type = get_random_number_in_range(min, max); // @note we don't want 0=empty and 8=enum_size
-    game_state->current_block.type = type;
-    
-    int half_screen = ((int)GRID_WIDTH/2);
-    Vector2 p[4];
-    
-    if (type == Block_Type::I)      { p[0]={-1,0}; p[1]={ 0,0}; p[2]={1,0}; p[3]={2,0}; }
-    else if (type == Block_Type::O) { p[0]={ 0,0}; p[1]={ 1,0}; p[2]={0,1}; p[3]={1,1}; }
-    else if (type == Block_Type::T) { p[0]={ 0,0}; p[1]={-1,1}; p[2]={0,1}; p[3]={1,1}; }
-    else if (type == Block_Type::S) { p[0]={-1,1}; p[1]={ 0,1}; p[2]={0,0}; p[3]={1,0}; }
-    else if (type == Block_Type::Z) { p[0]={-1,0}; p[1]={ 0,0}; p[2]={0,1}; p[3]={1,1}; }
-    else if (type == Block_Type::J) { p[0]={-1,0}; p[1]={-1,1}; p[2]={0,1}; p[3]={1,1}; }
-    else if (type == Block_Type::L) { p[0]={-1,1}; p[1]={ 0,1}; p[2]={1,1}; p[3]={1,0}; }
-    else {
-        // @todo assert
-        int *null_ = (int *)0;
-        *null_ = 1;
-    }
-    game_state->current_block.pos[0] = {p[0].x+half_screen, p[0].y};
-    game_state->current_block.pos[1] = {p[1].x+half_screen, p[1].y};
-    game_state->current_block.pos[2] = {p[2].x+half_screen, p[2].y};
-    game_state->current_block.pos[3] = {p[3].x+half_screen, p[3].y};
-    
-    b32 hit = is_block_colliding(game_state, &game_state->current_block);
-    if (hit)  {
-        // @note game over
-        reset_game(game_state, true);
-    }
-}
-
-internal void
-reset_game(Game_State *game_state, b32 clear_grid) {
-    // clear grid
-    for (int y = 0; y < GRID_HEIGHT; ++y) {
-        for (int x = 0; x < GRID_WIDTH; ++x) {
-            game_state->grid[y][x] = Block_Type::EMPTY;
-        }
-    }
-    
-    make_new_current_block(game_state);
-}
-
 internal void
 win32_resize_dib_section(Win32_Offscreen_Buffer *buffer, int width, int height) {
     if (buffer->memory) {
@@ -355,29 +171,48 @@ win32_get_window_dimension(HWND window) {
     return result;
 }
 
+// @note The backbuffer is already rendered at the largest integer scale that fits (see get_render_scale),
+//       so it gets copied 1:1 and centered. GDI only stretches if the window is smaller than the native size.
+//       The bars around the game only change with the layout, paint_bars is set on resize and WM_PAINT.
 internal void
-win32_display_buffer_in_window(Win32_Offscreen_Buffer *buffer, HDC device_context, int window_width, int window_height) {
-    // @todo better scaling, centering, black bars, ...
-    
-    int buffer_width = WINDOW_WIDTH;
-    int buffer_height = WINDOW_HEIGHT;
-    
-    f32 height_scale = (f32)window_height / (f32)buffer_height;
-    int new_width = (f32)buffer_width * height_scale;
-    int offset_x = (window_width - new_width) / 2;
-    if (new_width <= buffer_width)  {
-        offset_x = 0;
-        new_width = window_width;
-    }
-    else {
-        PatBlt(device_context, 0, 0, offset_x-2, window_height, BLACKNESS);
-        PatBlt(device_context, offset_x-2, 0, offset_x, window_height,  WHITENESS);
-        PatBlt(device_context, offset_x+new_width, 0, offset_x+buffer_width+2, window_height, WHITENESS);
-        PatBlt(device_context, offset_x+new_width+2, 0, window_width, window_height, BLACKNESS);
+win32_display_buffer_in_window(Win32_Offscreen_Buffer *buffer, HDC device_context, int window_width, int window_height,
+                               b32 paint_bars) {
+    if ((window_width < buffer->width) || (window_height < buffer->height)) {
+        f32 height_scale = (f32)window_height / (f32)buffer->height;
+        int new_width = (int)((f32)buffer->width * height_scale);
+        if (new_width > window_width)  new_width = window_width;
+        int offset_x = (window_width - new_width) / 2;
+        if (paint_bars) {
+            PatBlt(device_context, 0, 0, offset_x, window_height, BLACKNESS);
+            PatBlt(device_context, offset_x+new_width, 0, window_width - (offset_x+new_width), window_height, BLACKNESS);
+        }
+        StretchDIBits(device_context,
+                      offset_x, 0, new_width, window_height,
+                      0, 0, buffer->width, buffer->height,
+                      buffer->memory, &buffer->info,
+                      DIB_RGB_COLORS, SRCCOPY);
+        return;
     }
     
+    int offset_x = (window_width  - buffer->width)  / 2;
+    int offset_y = (window_height - buffer->height) / 2;
+    if (paint_bars) {
+        int border = 2;
+        int right_x = offset_x + buffer->width;
+        int bottom_y = offset_y + buffer->height;
+        PatBlt(device_context, 0, 0, window_width, offset_y, BLACKNESS);
+        PatBlt(device_context, 0, bottom_y, window_width, window_height - bottom_y, BLACKNESS);
+        PatBlt(device_context, 0, offset_y, offset_x, buffer->height, BLACKNESS);
+        PatBlt(device_context, right_x, offset_y, window_width - right_x, buffer->height, BLACKNESS);
+        if (offset_x >= border) {
+            PatBlt(device_context, offset_x-border, offset_y, border, buffer->height, WHITENESS);
+        }
+        if (window_width - right_x >= border) {
+            PatBlt(device_context, right_x, offset_y, border, buffer->height, WHITENESS);
+        }
+    }
     StretchDIBits(device_context,
-                  offset_x, 0, new_width, window_height,
+                  offset_x, offset_y, buffer->width, buffer->height,
                   0, 0, buffer->width, buffer->height,
                   buffer->memory, &buffer->info,
                   DIB_RGB_COLORS, SRCCOPY);
@@ -421,6 +256,10 @@ win32_main_window_callback(HWND window,
             OutputDebugStringA("WM_ACTIVATEAPP\n");
         } break;
         
+        case WM_DEVICECHANGE: {
+            atomic_exchange_u32(&global_xinput_devices_changed, 1);
+        } break;
+        
         case WM_DESTROY:
         case WM_CLOSE: {
             global_running = false;
@@ -441,7 +280,7 @@ win32_main_window_callback(HWND window,
             int width  = paint.rcPaint.right  - paint.rcPaint.left;
             int height = paint.rcPaint.bottom - paint.rcPaint.top;
             Win32_Window_Dimension dimension = win32_get_window_dimension(window);
-            win32_display_buffer_in_window(&global_backbuffer, device_context, dimension.width, dimension.height);
+            win32_display_buffer_in_window(&global_backbuffer, device_context, dimension.width, dimension.height, true);
             EndPaint(window, &paint);
         } break;
         
@@ -453,133 +292,241 @@ win32_main_window_callback(HWND window,
     return result;
 }
 
+inline LARGE_INTEGER
+win32_get_wall_clock() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter;
+}
+
+inline f32
+win32_get_seconds_elapsed(LARGE_INTEGER start, LARGE_INTEGER end) {
+    f32 result = ((f32)(end.QuadPart - start.QuadPart) / (f32)global_performance_count_frequency);
+    return result;
+}
+
+internal
+PLATFORM_GET_SECONDS_SIG(win32_get_seconds) {
+    LARGE_INTEGER counter = win32_get_wall_clock();
+    f64 result = (f64)counter.QuadPart / (f64)global_performance_count_frequency;
+    return result;
+}
+
+// @note the game button of a key, -1 if it is not one
+internal int
+win32_get_keyboard_button_index(u32 vk_code) {
+    int result = -1;
+    if (vk_code == 'W')  result = get_button_index(move_up); // @note hard drop
+    else if (vk_code == 'A')  result = get_button_index(move_left);
+    else if (vk_code == 'S')  result = get_button_index(move_down);
+    else if (vk_code == 'D')  result = get_button_index(move_right);
+    else if (vk_code == 'Q')  result = get_button_index(left_shoulder);
+    else if (vk_code == 'E')  result = get_button_index(right_shoulder);
+    else if (vk_code == VK_UP)  result = get_button_index(action_up);
+    else if (vk_code == VK_LEFT)  result = get_button_index(action_left);
+    else if ((vk_code == VK_DOWN) || (vk_code == 'K'))  result = get_button_index(action_down);
+    else if ((vk_code == VK_RIGHT) || (vk_code == 'J'))  result = get_button_index(action_right);
+    else if (vk_code == VK_RETURN)  result = get_button_index(start);
+    else if (vk_code == VK_BACK)  result = get_button_index(back); // @note rewind while held
+    return result;
+}
+
+// @note pushes an event if the button changed, key repeats and unchanged pad buttons are filtered out here
 internal void
-win32_clear_buffer(Win32_Offscreen_Buffer *buffer, Game_State *game_state) {
-    u8 *row = (u8 *)buffer->memory;
-    for (int y = 0; y < buffer->height; ++y) {
-        u32 *pixel = (u32 *)row;
-        for (int x = 0; x < buffer->width; ++x) {
-            *pixel++ = 0;
-        }
-        
-        row += buffer->pitch;
-    }
+win32_push_button(Win32_Input_Producer *producer, u32 controller_index, u32 button_index, b32 is_down, f64 seconds) {
+    u32 bit = (1u << button_index);
+    b32 was_down = ((producer->button_bits[controller_index] & bit) != 0);
+    if (was_down == is_down)  return;
+    producer->button_bits[controller_index] ^= bit;
+    Input_Event event = make_input_event(seconds, controller_index, button_index, is_down);
+    push_input_event(producer->queue, &event);
 }
 
 internal void
-win32_render_block(Win32_Offscreen_Buffer *buffer, Vector2 block_pos, enum32(Block_Type) type) {
-    if (type == Block_Type::EMPTY)  return;
-    Vector3 color_rgb = block_colors_by_type[(int)type];
-    //
-    s32 min_x = (block_pos.x * BLOCK_SIZE) + ((block_pos.x+1) * BLOCK_GAP_SIZE);
-    s32 min_y = (block_pos.y * BLOCK_SIZE) + ((block_pos.y+1) * BLOCK_GAP_SIZE);
-    s32 max_x = min_x + BLOCK_SIZE;
-    s32 max_y = min_y + BLOCK_SIZE;
-    
-    if (min_x < 0)  min_x = 0;
-    if (min_y < 0)  min_y = 0;
-    if (max_x > buffer->width)   max_x = buffer->width;
-    if (max_y > buffer->height)  max_y = buffer->height;
-    
-    u32 color = ((color_rgb.r << 16) |
-                 (color_rgb.g << 8)  |
-                 (color_rgb.b << 0));
-    
-    u8 *row = ((u8 *)buffer->memory +
-               min_x * buffer->bytes_per_pixel +
-               min_y * buffer->pitch);
-    for (int y = min_y; y < max_y; ++y) {
-        u32 *pixel = (u32 *)row;
-        for (int x = min_x; x < max_x; ++x) {
-            u32 _color = color;
-            if ((x==(min_x+0) && y==(min_y+0)) ||
-                (x==(min_x+1) && y==(min_y+1)) ||
-                (x==(min_x+1) && y==(min_y+2)) ||
-                (x==(min_x+2) && y==(min_y+1))) {
-                _color = 0xFFFFFFFF;
-            }
-            
-            *pixel = _color;
-            ++pixel;
-        }
-        row += buffer->pitch;
-    }
+win32_push_connection(Win32_Input_Producer *producer, u32 controller_index, b32 is_connected, f64 seconds) {
+    Input_Event event = make_input_event(seconds, controller_index, INPUT_EVENT_CONNECTION, is_connected);
+    push_input_event(producer->queue, &event);
 }
 
 internal void
-move_current_block_left(Game_State *game_state) {
-    b32 can_move = true;
-    for (int i = 0; i < 4; ++i) {
-        if (game_state->current_block.pos[i].x <= 0) {
-            can_move = false;
-        }
+win32_process_keyboard_key(Win32_Input_Producer *producer, u32 vk_code, b32 is_down, f64 seconds) {
+    int button_index = win32_get_keyboard_button_index(vk_code);
+    if (button_index < 0)  return;
+    // @note raw input sees the keys of every window, releases always go through so nothing stays held
+    if (is_down && GetForegroundWindow() != producer->game_window)  return;
+    win32_push_button(producer, 0, (u32)button_index, is_down, seconds);
+}
+
+// XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE 7689
+// XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE 8689
+inline f32
+win32_process_xinput_stick_value(SHORT value, SHORT deadzone_threshold) {
+    f32 result = 0;
+    if (value < -deadzone_threshold) {
+        result = (f32)((value + deadzone_threshold) / (32768.0f - deadzone_threshold));
     }
-    if (can_move)  {
-        Block old_block  = game_state->current_block;
-        for (int i = 0; i < 4; ++i) {
-            --game_state->current_block.pos[i].x;
-        }
-        b32 hit = is_block_colliding(game_state, &game_state->current_block);
-        if (hit)  {
-            for (int i = 0; i < 4; ++i) {
-                game_state->current_block.pos[i] = old_block.pos[i];
-            }
-        }
+    else if (value > deadzone_threshold){
+        result = (f32)((value - deadzone_threshold) / (32767.0f - deadzone_threshold));
     }
+    return result;
 }
 
+// @note pushes what changed on every pad since the last poll, the stick and the dpad are the move buttons
 internal void
-move_current_block_right(Game_State *game_state) {
-    b32 can_move = true;
-    for (int i = 0; i < 4; ++i) {
-        if (game_state->current_block.pos[i].x >= GRID_WIDTH-1) {
-            can_move = false;
-        }
-    }
-    if (can_move)  {
-        Block old_block  = game_state->current_block;
-        for (int i = 0; i < 4; ++i) {
-            ++game_state->current_block.pos[i].x;
-        }
-        b32 hit = is_block_colliding(game_state, &game_state->current_block);
-        if (hit)  {
-            for (int i = 0; i < 4; ++i) {
-                game_state->current_block.pos[i] = old_block.pos[i];
+win32_poll_xinput(Win32_Input_Producer *producer, f64 seconds) {
+    TIMED_BLOCK("xinput");
+    // @note read and cleared in one step, a WM_DEVICECHANGE in between would be lost otherwise
+    b32 devices_changed = (atomic_exchange_u32(&global_xinput_devices_changed, 0) != 0);
+    for (DWORD slot_index = 0; slot_index < XUSER_MAX_COUNT; ++slot_index) {
+        u32 controller_index = slot_index + 1;
+        Win32_XInput_Slot *slot = &producer->xinput_slots[slot_index];
+        if (!slot->is_connected && !devices_changed && seconds < slot->next_probe_seconds)  continue;
+        
+        XINPUT_STATE controller_state;
+        ZeroMemory(&controller_state, sizeof(XINPUT_STATE));
+        if (xinput_get_state(slot_index, &controller_state) != ERROR_SUCCESS) {
+            if (slot->is_connected) {
+                // @note a pad pulled out while a button is down must not leave it held
+                for (u32 button_index = 0; button_index < 32; ++button_index) {
+                    if (producer->button_bits[controller_index] & (1u << button_index)) {
+                        win32_push_button(producer, controller_index, button_index, false, seconds);
+                    }
+                }
+                win32_push_connection(producer, controller_index, false, seconds);
             }
+            slot->is_connected = false;
+            slot->probe_interval = (slot->probe_interval > 0) ? 2.0 * slot->probe_interval : XINPUT_MIN_PROBE_SECONDS;
+            if (slot->probe_interval > XINPUT_MAX_PROBE_SECONDS)  slot->probe_interval = XINPUT_MAX_PROBE_SECONDS;
+            slot->next_probe_seconds = seconds + slot->probe_interval;
+            continue;
         }
+        if (!slot->is_connected)  win32_push_connection(producer, controller_index, true, seconds);
+        slot->is_connected = true;
+        slot->probe_interval = 0;
+        
+        XINPUT_GAMEPAD *pad = &controller_state.Gamepad;
+        f32 stick_x = win32_process_xinput_stick_value(pad->sThumbLX, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
+        f32 stick_y = win32_process_xinput_stick_value(pad->sThumbLY, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
+        if (pad->wButtons & XINPUT_GAMEPAD_DPAD_UP)     stick_y = 1.0f;
+        if (pad->wButtons & XINPUT_GAMEPAD_DPAD_DOWN)   stick_y = -1.0f;
+        if (pad->wButtons & XINPUT_GAMEPAD_DPAD_LEFT)   stick_x = -1.0f;
+        if (pad->wButtons & XINPUT_GAMEPAD_DPAD_RIGHT)  stick_x = 1.0f;
+        
+        f32 threshold = 0.5f;
+        win32_push_button(producer, controller_index, get_button_index(move_left), stick_x < -threshold, seconds);
+        win32_push_button(producer, controller_index, get_button_index(move_right), stick_x > threshold, seconds);
+        win32_push_button(producer, controller_index, get_button_index(move_down), stick_y < -threshold, seconds);
+        win32_push_button(producer, controller_index, get_button_index(move_up), stick_y > threshold, seconds);
+        
+        WORD buttons = pad->wButtons;
+        win32_push_button(producer, controller_index, get_button_index(action_down), (buttons & XINPUT_GAMEPAD_A) != 0, seconds);
+        win32_push_button(producer, controller_index, get_button_index(action_right), (buttons & XINPUT_GAMEPAD_B) != 0, seconds);
+        win32_push_button(producer, controller_index, get_button_index(action_left), (buttons & XINPUT_GAMEPAD_X) != 0, seconds);
+        win32_push_button(producer, controller_index, get_button_index(action_up), (buttons & XINPUT_GAMEPAD_Y) != 0, seconds);
+        win32_push_button(producer, controller_index, get_button_index(left_shoulder), (buttons & XINPUT_GAMEPAD_LEFT_SHOULDER) != 0, seconds);
+        win32_push_button(producer, controller_index, get_button_index(right_shoulder), (buttons & XINPUT_GAMEPAD_RIGHT_SHOULDER) != 0, seconds);
+        win32_push_button(producer, controller_index, get_button_index(start), (buttons & XINPUT_GAMEPAD_START) != 0, seconds);
+        win32_push_button(producer, controller_index, get_button_index(back), (buttons & XINPUT_GAMEPAD_BACK) != 0, seconds);
     }
 }
 
-internal void
-win32_process_keyboard_message(Game_Button_State *new_state, b32 is_down) {
-    if (new_state->ended_down == is_down)  return;
-    new_state->ended_down = is_down;
-    ++new_state->half_transition_count;
+// @note the input thread's own window only receives raw keyboard input, timestamped as soon as it arrives
+LRESULT CALLBACK
+win32_input_window_callback(HWND window,
+                            UINT message,
+                            WPARAM wparam,
+                            LPARAM lparam) {
+    if (message == WM_INPUT) {
+        f64 seconds = win32_get_seconds();
+        RAWINPUT raw_input;
+        UINT size = sizeof(raw_input);
+        if (GetRawInputData((HRAWINPUT)lparam, RID_INPUT, &raw_input, &size, sizeof(RAWINPUTHEADER)) != (UINT)-1 &&
+            raw_input.header.dwType == RIM_TYPEKEYBOARD) {
+            b32 is_down = ((raw_input.data.keyboard.Flags & RI_KEY_BREAK) == 0);
+            win32_process_keyboard_key(&global_input_producer, raw_input.data.keyboard.VKey, is_down, seconds);
+        }
+    }
+    // @note WM_INPUT has to go through DefWindowProc as well, it cleans up after the raw input
+    LRESULT result = DefWindowProcA(window, message, wparam, lparam);
+    return result;
 }
 
-internal void
-win32_process_xinput_digital_button(DWORD xinput_button_state,
-                                    Game_Button_State *old_state, DWORD button_bit,
-                                    Game_Button_State *new_state) {
-    b32 is_down = ((xinput_button_state & button_bit) == button_bit);
-    new_state->ended_down = false;
-    if (!is_down)  {
-        new_state->allow_press = true;
-        return;
+// @note Waits for raw keyboard input with a timeout of WIN32_INPUT_POLL_MS and polls XInput after every wake up.
+//       The message-only window has to be created here, its messages go to the thread that created it.
+DWORD WINAPI
+win32_input_thread_proc(LPVOID parameter) {
+    Win32_Input_Producer *producer = (Win32_Input_Producer *)parameter;
+    
+    WNDCLASSA window_class = {};
+    window_class.lpfnWndProc = win32_input_window_callback;
+    window_class.hInstance = GetModuleHandleA(0);
+    window_class.lpszClassName = "TetrisInputWindowClass";
+    RegisterClassA(&window_class);
+    HWND input_window = CreateWindowExA(0, window_class.lpszClassName, "", 0, 0, 0, 0, 0,
+                                        HWND_MESSAGE, 0, window_class.hInstance, 0);
+    
+    // @note generic desktop keyboard, with INPUTSINK the keys come in although the message-only window never has the focus
+    RAWINPUTDEVICE keyboard_device = {};
+    keyboard_device.usUsagePage = 0x01;
+    keyboard_device.usUsage = 0x06;
+    keyboard_device.dwFlags = RIDEV_INPUTSINK;
+    keyboard_device.hwndTarget = input_window;
+    producer->has_raw_keyboard = (input_window && RegisterRawInputDevices(&keyboard_device, 1, sizeof(keyboard_device)));
+    SetEvent(producer->ready_event);
+    if (!producer->has_raw_keyboard) {
+        if (input_window)  DestroyWindow(input_window);
+        return 0;
     }
-    else {
-        new_state->allow_press = false;
-        
-        if (old_state->allow_press)  {
-            new_state->ended_down = is_down;
-            new_state->half_transition_count = (old_state->ended_down != new_state->ended_down) ? 1 : 0;
-            return;
+    
+    while (global_input_thread_running) {
+        MsgWaitForMultipleObjectsEx(0, 0, WIN32_INPUT_POLL_MS, QS_RAWINPUT, MWMO_INPUTAVAILABLE);
+        MSG message;
+        while (PeekMessageA(&message, 0, 0, 0, PM_REMOVE)) {
+            DispatchMessageA(&message);
         }
+        win32_poll_xinput(producer, win32_get_seconds());
     }
+    DestroyWindow(input_window);
+    return 0;
+}
+
+// @note false if the thread or its raw keyboard input can not be set up, the main thread produces the input then
+internal b32
+win32_start_input_thread(Win32_Input_Producer *producer) {
+    producer->ready_event = CreateEventA(0, TRUE, FALSE, 0);
+    if (!producer->ready_event)  return false;
+    global_input_thread_running = true;
+    HANDLE thread = CreateThread(0, 0, win32_input_thread_proc, producer, 0, 0);
+    if (thread)  WaitForSingleObject(producer->ready_event, INFINITE);
+    CloseHandle(producer->ready_event);
+    producer->ready_event = 0;
+    if (!thread || !producer->has_raw_keyboard) {
+        global_input_thread_running = false;
+        if (thread) {
+            WaitForSingleObject(thread, INFINITE);
+            CloseHandle(thread);
+        }
+        return false;
+    }
+    // @note above the main thread, so a press is timestamped when it arrives and not when the frame lets go of the core
+    SetThreadPriority(thread, THREAD_PRIORITY_HIGHEST);
+    global_input_thread = thread;
+    return true;
 }
 
 internal void
-win32_process_pending_messages(Game_Controller_Input *keyboard_controller) {
+win32_stop_input_thread() {
+    if (!global_input_thread)  return;
+    global_input_thread_running = false;
+    WaitForSingleObject(global_input_thread, INFINITE);
+    CloseHandle(global_input_thread);
+    global_input_thread = 0;
+}
+
+// @note The window's messages, the keys for the game itself come in through the input thread. If it could not
+//       be started the main thread is the producer and pushes them from here.
+internal void
+win32_process_pending_messages() {
     MSG message;
     while (PeekMessage(&message, 0, 0, 0, PM_REMOVE)) {
         switch (message.message) {
@@ -597,44 +544,26 @@ win32_process_pending_messages(Game_Controller_Input *keyboard_controller) {
                 b32 was_down = ((message.lParam & (1 << 30)) != 0);
                 b32 is_down = ((message.lParam & (1 << 31)) == 0);
                 if (was_down != is_down) {
-                    if (vk_code == 'W') {
-                        win32_process_keyboard_message(&keyboard_controller->move_up, is_down);
-                    }
-                    else if (vk_code == 'A') {
-                        win32_process_keyboard_message(&keyboard_controller->move_left, is_down);
-                    }
-                    else if (vk_code == 'S') {
-                        win32_process_keyboard_message(&keyboard_controller->move_down, is_down);
-                    }
-                    else if (vk_code == 'D') {
-                        win32_process_keyboard_message(&keyboard_controller->move_right, is_down);
-                    }
-                    else if (vk_code == 'Q') {
-                        win32_process_keyboard_message(&keyboard_controller->left_shoulder, is_down);
-                    }
-                    else if (vk_code == 'E') {
-                        win32_process_keyboard_message(&keyboard_controller->right_shoulder, is_down);
+                    if (!global_input_thread) {
+                        win32_process_keyboard_key(&global_input_producer, vk_code, is_down, win32_get_seconds());
                     }
-                    else if (vk_code == VK_UP) {
-                        win32_process_keyboard_message(&keyboard_controller->action_up, is_down);
-                    }
-                    else if (vk_code == VK_LEFT) {
-                        win32_process_keyboard_message(&keyboard_controller->action_left, is_down);
+                    if (vk_code == VK_ESCAPE) {
+                        global_running = false;
                     }
-                    else if ((vk_code == VK_DOWN) || (vk_code == 'K')) {
-                        win32_process_keyboard_message(&keyboard_controller->action_down, is_down);
+                    if (vk_code == VK_F5 && is_down) {
+                        global_save_snapshot = true;
                     }
-                    else if ((vk_code == VK_RIGHT) || (vk_code == 'J')) {
-                        win32_process_keyboard_message(&keyboard_controller->action_right, is_down);
+                    if (vk_code == VK_F6 && is_down) {
+                        global_load_snapshot = true;
                     }
-                    else if (vk_code == VK_RETURN) {
-                        win32_process_keyboard_message(&keyboard_controller->start, is_down);
+                    if (vk_code == VK_F8 && is_down) {
+                        global_bot_enabled = !global_bot_enabled;
                     }
-                    else if (vk_code == VK_BACK) {
-                        win32_process_keyboard_message(&keyboard_controller->back, is_down);
+                    if (vk_code == VK_F9 && is_down) {
+                        global_write_frame_log = true;
                     }
-                    if (vk_code == VK_ESCAPE) {
-                        global_running = false;
+                    if (vk_code == VK_F10 && is_down) {
+                        global_show_debug_overlay = !global_show_debug_overlay;
                     }
                     
                     if (is_down) {
@@ -661,19 +590,62 @@ win32_process_pending_messages(Game_Controller_Input *keyboard_controller) {
     }
 }
 
-inline LARGE_INTEGER
-win32_get_wall_clock() {
-    LARGE_INTEGER counter;
-    QueryPerformanceCounter(&counter);
-    return counter;
+// @note prefers a high resolution waitable timer, falls back to a regular one and then to Sleep
+internal void
+win32_create_frame_timer() {
+    global_frame_timer = CreateWaitableTimerExW(0, 0, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!global_frame_timer) {
+        global_frame_timer = CreateWaitableTimerA(0, TRUE, 0);
+    }
 }
 
-inline f32
-win32_get_seconds_elapsed(LARGE_INTEGER start, LARGE_INTEGER end) {
-    f32 result = ((f32)(end.QuadPart - start.QuadPart) / (f32)global_performance_count_frequency);
+internal
+PLATFORM_SLEEP_SECONDS_SIG(win32_sleep_seconds) {
+    if (seconds <= 0)  return;
+    if (global_frame_timer) {
+        // @note negative due time is relative, in 100ns units
+        LARGE_INTEGER due_time;
+        due_time.QuadPart = -(LONGLONG)(seconds * 10000000.0);
+        if (SetWaitableTimer(global_frame_timer, &due_time, 0, 0, 0, FALSE)) {
+            WaitForSingleObject(global_frame_timer, INFINITE);
+            return;
+        }
+    }
+    DWORD sleep_ms = (DWORD)(seconds * 1000.0);
+    if (sleep_ms > 0)  Sleep(sleep_ms);
+}
+
+// @note rdtsc rate measured against the performance counter since startup
+internal f64
+win32_get_cycles_per_second() {
+    f64 seconds = win32_get_seconds() - global_start_seconds;
+    f64 result = (seconds > 0.0) ? (f64)(__rdtsc() - global_start_cycle_count) / seconds : 0.0;
     return result;
 }
 
+// @note into the working directory, overwrites the previous dump
+internal void
+win32_write_frame_log() {
+    write_frame_log_csv(&global_frame_log, "frame_times.csv");
+    write_frame_log_json(&global_frame_log, "frame_times.json");
+#if TETRIS_PROFILE
+    write_debug_trace_json("frame_trace.json", win32_get_cycles_per_second());
+#endif
+    
+    Frame_Log_Summary summary = summarize_frame_log(&global_frame_log);
+    u64 event_count = global_input_tracker.taken_count;
+    f64 event_latency_ms = event_count ? (global_input_event_latency_sum / (f64)event_count) * 1000.0 : 0.0;
+    char summary_buffer[384];
+    _snprintf_s(summary_buffer, sizeof(summary_buffer),
+                "%llu frames, %.02ffps, frame ms p50 %.02f p95 %.02f p99 %.02f max %.02f, latency ms p50 %.02f p95 %.02f, "
+                "%llu input events %llu dropped, %.02f ms from the event to the present\n",
+                summary.frame_count, summary.mean_fps,
+                summary.frame_ms.p50, summary.frame_ms.p95, summary.frame_ms.p99, summary.frame_ms.max,
+                summary.latency_ms.p50, summary.latency_ms.p95,
+                event_count, global_input_queue.dropped_count, event_latency_ms);
+    OutputDebugStringA(summary_buffer);
+}
+
 int CALLBACK
 WinMain(HINSTANCE instance,
         HINSTANCE prev_instance,
@@ -682,11 +654,16 @@ WinMain(HINSTANCE instance,
     LARGE_INTEGER performance_count_frequency_result;
     QueryPerformanceFrequency(&performance_count_frequency_result);
     global_performance_count_frequency = performance_count_frequency_result.QuadPart;
+    global_start_seconds = win32_get_seconds();
+    global_start_cycle_count = __rdtsc();
     
+    // @note also makes the fallback timers granular, the frame scheduler measures what we actually get
     UINT desired_scheduler_ms = 1;
-    b32 sleep_is_granular = (timeBeginPeriod(desired_scheduler_ms) == TIMERR_NOERROR);
+    timeBeginPeriod(desired_scheduler_ms);
+    win32_create_frame_timer();
     
     win32_load_xinput();
+    init_renderer();
     
     win32_resize_dib_section(&global_backbuffer, WIDTH, HEIGHT);
     
@@ -716,353 +693,235 @@ WinMain(HINSTANCE instance,
     if (win32_refresh_rate > 1)  {
         monitor_refresh_hz = win32_refresh_rate;
     }
-    f32 game_update_hz = (monitor_refresh_hz / 2.0f);
-    f32 target_seconds_per_frame =  1.0f / (f32)game_update_hz;
-    f32 dt = target_seconds_per_frame;
+    // @note rendering runs at the display rate, the simulation at its own fixed tick rate
+    f32 render_hz = (f32)monitor_refresh_hz;
+    
+    Frame_Scheduler frame_scheduler;
+    init_frame_scheduler(&frame_scheduler, render_hz, win32_get_seconds, win32_sleep_seconds);
+    
+    // @note command line: [tick_hz] [-20g] [-rewind megabytes] [-early-input]
+    u32 tick_hz = GAME_TICK_HZ;
+    b32 instant_gravity = false;
+    b32 late_input_latch = true; // @note -early-input polls at the frame start instead of at the input latch
+    u64 rewind_megabytes = 16; // @note 1200 bytes per 64 steps, about 4 hours of history at 60 steps per second
+    if (cmd_line && cmd_line[0]) {
+        int requested_tick_hz = atoi(cmd_line);
+        if (requested_tick_hz > 0 && requested_tick_hz <= MAX_TICK_HZ)  tick_hz = (u32)requested_tick_hz;
+        instant_gravity = (strstr(cmd_line, "-20g") != 0);
+        late_input_latch = (strstr(cmd_line, "-early-input") == 0);
+        char *rewind_arg = strstr(cmd_line, "-rewind ");
+        if (rewind_arg)  rewind_megabytes = (u64)atoi(rewind_arg + 8);
+    }
     
-    f32 move_update_frequency_ms = 200.0f;
-    LARGE_INTEGER last_move_counter = win32_get_wall_clock();
+    LARGE_INTEGER last_simulate_counter = win32_get_wall_clock();
+    Tick_Accumulator tick_accumulator = {};
+    Game_Controller_Input pending_input = {}; // @note the bot's input until the next tick
     
     LARGE_INTEGER perf_count_frequency_result;
     QueryPerformanceFrequency(&perf_count_frequency_result);
     s64 perf_count_frequency = perf_count_frequency_result.QuadPart;
     
-    Game_Input input[2] = {};
-    Game_Input *new_input = &input[0];
-    Game_Input *old_input = &input[1];
-    
-    int active_controller_index = 0;
+    // @note every button transition goes through the input queue with its time, the simulation takes it at the
+    //       first tick after it happened
+    global_input_producer.queue = &global_input_queue;
+    global_input_producer.game_window = window;
+    win32_push_connection(&global_input_producer, 0, true, win32_get_seconds());
+    win32_start_input_thread(&global_input_producer);
+    Game_Input tick_input = {};
+    b32 is_rewinding = false;
+    
+    u32 active_controller_index = 0;
+    
+    Game_State game_state;
+    init_game(&game_state, __rdtsc(), tick_hz, instant_gravity);
+    
+    // @note every session is recorded into the working directory, replay it with tetris_headless --replay
+    FILE *replay_file = fopen("session.tetris_replay", "wb");
+    Replay_Recorder replay_recorder;
+    begin_replay_recording(&replay_recorder, replay_file, &game_state);
+    
+    // @note the rewind history gets all its memory up front, 0 megabytes turns rewinding off
+    Rewind_Buffer rewind = {};
+    u64 rewind_memory_size = rewind_megabytes * 1024 * 1024;
+    void *rewind_memory = rewind_memory_size ? VirtualAlloc(0, rewind_memory_size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE) : 0;
+    init_rewind_buffer(&rewind, rewind_memory, rewind_memory_size);
+    
+    // @note the planner keeps its transposition table and the pathfinder its cache between pieces, allocated once
+    Bot bot = {};
+    Planner *planner = (Planner *)VirtualAlloc(0, sizeof(Planner), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    Pathfinder *pathfinder = (Pathfinder *)VirtualAlloc(0, sizeof(Pathfinder), MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    if (planner) {
+        Planner_Settings bot_settings = { 3, 32, 0.002 };
+        init_bot(&bot, planner, pathfinder, bot_settings);
+    }
     
-    Game_State game_state = {};
-    reset_game(&game_state, false);
+    Render_State render_state = {};
+    Win32_Window_Dimension last_presented_dimension = {};
     
     global_running = true;
     
-    LARGE_INTEGER last_counter = win32_get_wall_clock();
-    QueryPerformanceCounter(&last_counter);
     u64 last_cycle_count = __rdtsc();
     while (global_running) {
-        auto add_block_to_grid = [](Game_State *game_state, Block *block) {
-            for (int i = 0; i < 4; ++i) {
-                game_state->grid[block->pos[i].y][block->pos[i].x] = block->type;
-            }
-        };
-        
-        Block old_block  = game_state.current_block;
-        
         //
         // @note handle input
         //
         
-        Game_Controller_Input *old_keyboard_controller = get_controller(old_input, 0);
-        Game_Controller_Input *new_keyboard_controller = get_controller(new_input, 0);
-        *new_keyboard_controller = {};
-        new_keyboard_controller->is_connected = true;
-        
-#if 0
-        for (int button_index = 0; button_index < array_count(new_keyboard_controller->buttons); ++button_index) {
-            new_keyboard_controller->buttons[button_index].ended_down = old_keyboard_controller->buttons[button_index].ended_down;
-        }
-#endif
-        
-        win32_process_pending_messages(new_keyboard_controller);
-        
-        DWORD max_controller_count = XUSER_MAX_COUNT;
-        DWORD input_controller_count = array_count(input->controllers) - 1;
-        if (max_controller_count > input_controller_count) {
-            max_controller_count = input_controller_count;
-        }
-        for (DWORD controller_index = 0; controller_index < max_controller_count; ++controller_index) {
-            DWORD our_controller_index = controller_index + 1;
-            Game_Controller_Input *old_controller = get_controller(old_input, our_controller_index);
-            Game_Controller_Input *new_controller = get_controller(new_input, our_controller_index);
-            *new_controller = {};
-            
-            XINPUT_STATE controller_state;
-            ZeroMemory(&controller_state, sizeof(XINPUT_STATE));
-            if (xinput_get_state(controller_index, &controller_state) != ERROR_SUCCESS) {
-                new_controller->is_connected = false;
-                continue;
-            }
-            
-            new_controller->is_connected = true;
-            new_controller->is_analog = old_controller->is_analog;
-            XINPUT_GAMEPAD *pad = &controller_state.Gamepad;
-            
-            // XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE 7689
-            // XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE 8689
-            auto process_xinput_stick_value = [](SHORT value, SHORT deadzone_threshold) {
-                f32 result = 0;
-                if (value < -deadzone_threshold) {
-                    result = (f32)((value + deadzone_threshold) / (32768.0f - deadzone_threshold));
-                }
-                else if (value > deadzone_threshold){
-                    result = (f32)((value - deadzone_threshold) / (32767.0f - deadzone_threshold));
-                }
-                return result;
-            };
-            
-            new_controller->stick_average_x = process_xinput_stick_value(pad->sThumbLX, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
-            new_controller->stick_average_y = process_xinput_stick_value(pad->sThumbLY, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
-            if ((new_controller->stick_average_x != 0.0f) ||
-                (new_controller->stick_average_y != 0.0f)) {
-                new_controller->is_analog = true;
-            }
-            
-            if (pad->wButtons & XINPUT_GAMEPAD_DPAD_UP) {
-                new_controller->stick_average_y = 1.0f;
-                new_controller->is_analog = false;
-            }
-            if (pad->wButtons & XINPUT_GAMEPAD_DPAD_DOWN) {
-                new_controller->stick_average_y = -1.0f;
-                new_controller->is_analog = false;
-            }
-            if (pad->wButtons & XINPUT_GAMEPAD_DPAD_LEFT) {
-                new_controller->stick_average_x = -1.0f;
-                new_controller->is_analog = false;
-            }
-            if (pad->wButtons & XINPUT_GAMEPAD_DPAD_RIGHT) {
-                new_controller->stick_average_x = 1.0f;
-                new_controller->is_analog = false;
-            }
-            
-            f32 threshold = 0.5f;
-            win32_process_xinput_digital_button((new_controller->stick_average_x < -threshold) ? 1 : 0,
-                                                &old_controller->move_left, 1,
-                                                &new_controller->move_left);
-            win32_process_xinput_digital_button((new_controller->stick_average_x > threshold) ? 1 : 0,
-                                                &old_controller->move_right, 1,
-                                                &new_controller->move_right);
-            win32_process_xinput_digital_button((new_controller->stick_average_y < -threshold) ? 1 : 0,
-                                                &old_controller->move_down, 1,
-                                                &new_controller->move_down);
-            win32_process_xinput_digital_button((new_controller->stick_average_y > threshold) ? 1 : 0,
-                                                &old_controller->move_up, 1,
-                                                &new_controller->move_up);
-            
-            win32_process_xinput_digital_button(pad->wButtons,
-                                                &old_controller->action_down, XINPUT_GAMEPAD_A,
-                                                &new_controller->action_down);
-            win32_process_xinput_digital_button(pad->wButtons,
-                                                &old_controller->action_right, XINPUT_GAMEPAD_B,
-                                                &new_controller->action_right);
-            win32_process_xinput_digital_button(pad->wButtons,
-                                                &old_controller->action_left, XINPUT_GAMEPAD_X,
-                                                &new_controller->action_left);
-            win32_process_xinput_digital_button(pad->wButtons,
-                                                &old_controller->action_up, XINPUT_GAMEPAD_Y,
-                                                &new_controller->action_up);
-            
-            win32_process_xinput_digital_button(pad->wButtons,
-                                                &old_controller->left_shoulder, XINPUT_GAMEPAD_LEFT_SHOULDER,
-                                                &new_controller->left_shoulder);
-            win32_process_xinput_digital_button(pad->wButtons,
-                                                &old_controller->right_shoulder, XINPUT_GAMEPAD_RIGHT_SHOULDER,
-                                                &new_controller->right_shoulder);
-            
-            win32_process_xinput_digital_button(pad->wButtons,
-                                                &old_controller->start, XINPUT_GAMEPAD_START,
-                                                &new_controller->start);
-            win32_process_xinput_digital_button(pad->wButtons,
-                                                &old_controller->back, XINPUT_GAMEPAD_BACK,
-                                                &new_controller->back);
-        }
-        
-        //
-        // @note do input
-        //
-        
-        for (DWORD controller_index = 0; controller_index < input_controller_count; ++controller_index) {
-            Game_Controller_Input *controller = get_controller(old_input, controller_index);
-            if (controller->start.ended_down)  {
-                active_controller_index = controller_index;
-            }
-        }
+        // @note everything from here to the present is the frame's work, the input latch moves it to the end of
+        //       the frame. GDI shows the frame when it is presented, not at the frame end, so this does not shorten
+        //       the logged latency (see tetris_frame.h)
+        if (late_input_latch)  wait_for_input_latch(&frame_scheduler);
+        f64 input_seconds = win32_get_seconds();
         
         {
-            Game_Controller_Input *controller = get_controller(new_input, active_controller_index);
-            
-            if (controller->move_up.ended_down) {
-            }
-            else if (controller->move_left.ended_down) {
-                move_current_block_left(&game_state);
-            }
-            else if (controller->move_down.ended_down) {
-                Block old_block  = game_state.current_block;
-                for (int i = 0; i < 4; ++i) {
-                    ++game_state.current_block.pos[i].y;
-                }
-                b32 valid = (is_block_colliding(&game_state, &game_state.current_block) ||
-                             is_block_out_of_bounds(&game_state.current_block));
-                if (valid)  {
-                    game_state.current_block = old_block;
-                }
-            }
-            else if (controller->move_right.ended_down) {
-                move_current_block_right(&game_state);
-            }
-            else if (controller->action_right.ended_down || controller->action_down.ended_down) {
-                b32 clockwise = (controller->action_down.ended_down) ? true : false;
-                
-                Block old_block  = game_state.current_block;
-                rotate_block(&game_state.current_block, clockwise);
-                b32 valid = (is_block_colliding(&game_state, &game_state.current_block) ||
-                             is_block_out_of_bounds(&game_state.current_block));
-                if (valid)  {
-                    game_state.current_block = old_block;
-                }
-            }
+            TIMED_BLOCK("input polling");
+            win32_process_pending_messages();
+            if (!global_input_thread)  win32_poll_xinput(&global_input_producer, input_seconds);
         }
         
         //
         // @note simulate
         //
         
-        // @note check if current_block hit other blocks because of the player input
-        b32 hit = is_block_colliding(&game_state, &game_state.current_block);
-        if (hit)  {
-            for (int i = 0; i < 4; ++i) {
-                game_state.current_block.pos[i] = old_block.pos[i];
-            }
-        }
-        
-        // @note check if current_block hit the bottom
-        old_block = game_state.current_block;
-        // @note move the current_block downward
-        f32 ms_since_last_move = 1000.0f * win32_get_seconds_elapsed(last_move_counter, win32_get_wall_clock());
-        if (ms_since_last_move >= move_update_frequency_ms) {
-            for (int i = 0; i < 4; ++i) {
-                ++game_state.current_block.pos[i].y;
-            }
-            
-            last_move_counter = win32_get_wall_clock();
+        LARGE_INTEGER simulate_counter = win32_get_wall_clock();
+        f64 simulate_seconds = ((f64)(simulate_counter.QuadPart - last_simulate_counter.QuadPart) /
+                                (f64)global_performance_count_frequency);
+        f64 now_seconds = (f64)simulate_counter.QuadPart / (f64)global_performance_count_frequency;
+        last_simulate_counter = simulate_counter;
+        if (global_save_snapshot) {
+            Snapshot snapshot;
+            save_snapshot(&game_state, &snapshot);
+            FILE *snapshot_file = fopen("session.tetris_snapshot", "wb");
+            write_snapshot_file(snapshot_file, &snapshot, 1);
+            if (snapshot_file)  fclose(snapshot_file);
+            global_save_snapshot = false;
         }
-        b32 out_of_bounds = is_block_out_of_bounds(&game_state.current_block);
-        if (out_of_bounds)  {
-            // set current_block pos to old_block pos
-            for (int i = 0; i < 4; ++i) {
-                game_state.current_block.pos[i] = old_block.pos[i];
+        if (global_load_snapshot) {
+            // @note a damaged or missing file leaves the game as it is, the recording ends with the game it recorded
+            FILE *snapshot_file = fopen("session.tetris_snapshot", "rb");
+            Snapshot snapshot;
+            local_persist Game_State loaded_state;
+            if (read_snapshot_file(snapshot_file, &snapshot) && load_snapshot(&snapshot, &loaded_state)) {
+                end_replay_recording(&replay_recorder, &game_state);
+                clear_rewind_buffer(&rewind);
+                game_state = loaded_state;
+                pending_input = {};
+                render_state.is_valid = false;
             }
-            
-            add_block_to_grid(&game_state, &old_block);
-            make_new_current_block(&game_state);
+            if (snapshot_file)  fclose(snapshot_file);
+            global_load_snapshot = false;
         }
         
-        // @note check if current block hit other blocks after moving downward
-        hit = is_block_colliding(&game_state, &game_state.current_block);
-        if (hit)  {
-            for (int i = 0; i < 4; ++i) {
-                game_state.current_block.pos[i] = old_block.pos[i];
-            }
-            add_block_to_grid(&game_state, &old_block);
-            make_new_current_block(&game_state);
+        u32 ticks = accumulate_ticks(&tick_accumulator, simulate_seconds, game_state.tick_hz, game_state.tick_hz / 4);
+        u64 taken_count = global_input_tracker.taken_count;
+        f64 taken_seconds_sum = global_input_tracker.taken_seconds_sum;
+        
+        // @note Holding back rewinds one recorded step per frame instead of simulating, the ticks and the input
+        //       that come due meanwhile are dropped. The first rewound frame ends the replay recording, it can not
+        //       follow the game back in time.
+        Game_Controller_Input *held_controller = get_controller(&global_input_tracker.held, active_controller_index);
+        if (held_controller->back.ended_down && rewind.chunk_capacity) {
+            take_input_events(&global_input_queue, &global_input_tracker, now_seconds, &tick_input);
+            if (!is_rewinding)  end_replay_recording(&replay_recorder, &game_state);
+            is_rewinding = true;
+            if (rewind.step_count > 0)  rewind_to_step(&rewind, rewind.step_count - 1, &game_state);
+            pending_input = {};
         }
-        
-        //
-        // @note check for tetris
-        //
-        // @todo for_each line check if full, and move everything down
-        // @todo @note If top most line is full, -> game over
-        int line_streak_count = 0;
-        for (int current_line = GRID_HEIGHT-1; current_line >= 0; --current_line) {
-            b32 line_full = true;
-            for (int x = 0; x < GRID_WIDTH; ++x) {
-                if (game_state.grid[current_line][x] == Block_Type::EMPTY) {
-                    line_full = false;
-                    line_streak_count = 0;
-                }
-                else {
-                    ++line_streak_count;
-                }
+        else {
+            is_rewinding = false;
+            b32 bot_is_playing = (global_bot_enabled && planner);
+            if (bot_is_playing) {
+                Game_Controller_Input bot_controller;
+                get_bot_input(&bot, &game_state, win32_get_seconds, &bot_controller);
+                merge_controller_input(&pending_input, &bot_controller);
             }
-            if (line_full)  {
-                if (line_streak_count == 4)  {
-                    // @todo BOOM TETRIS
+            
+            // @note one step per tick, each with the input that happened before the tick's time
+            for (u32 tick = 0; tick < ticks; ++tick) {
+                f64 tick_seconds = get_tick_seconds(&tick_accumulator, now_seconds, game_state.tick_hz, ticks, tick);
+                take_input_events(&global_input_queue, &global_input_tracker, tick_seconds, &tick_input);
+                for (u32 controller_index = 0; controller_index < array_count(tick_input.controllers); ++controller_index) {
+                    if (tick_input.controllers[controller_index].start.ended_down)  active_controller_index = controller_index;
                 }
                 
-                // @note move all blocks done 1, skip last line
-                for (int y = current_line-1; y >= 0; --y) {
-                    for (int x = 0; x < GRID_WIDTH; ++x) {
-                        game_state.grid[y+1][x] = game_state.grid[y][x];
-                    }
-                }
-                // @note clear top most line, because it got moved down by one
-                for (int x = 0; x < GRID_WIDTH; ++x) {
-                    game_state.grid[0][x] = Block_Type::EMPTY;
-                }
+                Game_Controller_Input *controller = get_controller(&tick_input, active_controller_index);
+                if (bot_is_playing)  controller = &pending_input;
+                record_replay_step(&replay_recorder, &game_state, controller, 1);
+                record_rewind_step(&rewind, &game_state, controller, 1);
+                game_step(&game_state, controller, 1);
+                pending_input = {};
             }
         }
         
         //
         // @note render
         //
-        win32_clear_buffer(&global_backbuffer, &game_state);
         
-        // @note render grid
-        for (int y = 0; y < GRID_HEIGHT; ++y) {
-            for (int x = 0; x < GRID_WIDTH; ++x) {
-                int type = game_state.grid[y][x];
-                if (type > 0)  {
-                    win32_render_block(&global_backbuffer, Vector2{x,y}, type);
-                }
+        // @note the backbuffer follows the integer scale of the window, the renderer redraws everything once it changed
+        Win32_Window_Dimension dimension = win32_get_window_dimension(window);
+        b32 dimension_changed = ((dimension.width  != last_presented_dimension.width) ||
+                                 (dimension.height != last_presented_dimension.height));
+        if (dimension_changed) {
+            int scale = get_render_scale(dimension.width, dimension.height);
+            if (global_backbuffer.width != WIDTH * scale) {
+                win32_resize_dib_section(&global_backbuffer, WIDTH * scale, HEIGHT * scale);
+                render_state.is_valid = false;
             }
         }
-        // @note render current_block
-        for (int i = 0; i < 4; ++i) {
-            win32_render_block(&global_backbuffer, game_state.current_block.pos[i], game_state.current_block.type);
+        
+        Game_Offscreen_Buffer buffer = {};
+        buffer.memory = global_backbuffer.memory;
+        buffer.width = global_backbuffer.width;
+        buffer.height = global_backbuffer.height;
+        buffer.pitch = global_backbuffer.pitch;
+        buffer.bytes_per_pixel = global_backbuffer.bytes_per_pixel;
+        render_game(&render_state, &buffer, &game_state, get_tick_alpha(&tick_accumulator));
+        
+#if TETRIS_PROFILE
+        if (global_show_debug_overlay) {
+            u64 budget_cycles = (u64)(win32_get_cycles_per_second() * frame_scheduler.target_seconds_per_frame);
+            render_debug_overlay(&buffer, budget_cycles);
+            render_state.dirty_rect = { 0, 0, buffer.width, buffer.height };
+            render_state.is_valid = false;
         }
+#endif
         
-        Win32_Window_Dimension dimension = win32_get_window_dimension(window);
-        win32_display_buffer_in_window(&global_backbuffer, device_context, dimension.width, dimension.height);
+        // @note skip presenting if no cell changed, WM_PAINT takes care of anything the window itself invalidates
+        if (!is_rect_empty(render_state.dirty_rect) || dimension_changed) {
+            TIMED_BLOCK("present");
+            win32_display_buffer_in_window(&global_backbuffer, device_context, dimension.width, dimension.height,
+                                           dimension_changed);
+            last_presented_dimension = dimension;
+        }
+        f64 present_seconds = win32_get_seconds();
+        f64 latency_seconds = present_seconds - input_seconds; // @note to the present, GDI shows the frame from there
+        global_input_event_latency_sum += ((f64)(global_input_tracker.taken_count - taken_count) * present_seconds -
+                                           (global_input_tracker.taken_seconds_sum - taken_seconds_sum));
         
         //
         // @note frame rate
         //
-        LARGE_INTEGER work_counter = win32_get_wall_clock();
-        f32 seconds_elapsed_for_work = win32_get_seconds_elapsed(last_counter, work_counter);
-        
-        f32 seconds_elapsed_for_frame = seconds_elapsed_for_work;
-        if (seconds_elapsed_for_frame < target_seconds_per_frame) {
-            DWORD sleep_ms;
-            if (sleep_is_granular)  {
-                sleep_ms = (DWORD)(1000 * (DWORD)(target_seconds_per_frame - seconds_elapsed_for_frame));
-                if (sleep_ms > 0)  {
-                    Sleep(sleep_ms);
-                }
-            }
-            
-            f32 test_seconds_elapsed_for_frame = win32_get_seconds_elapsed(last_counter, win32_get_wall_clock());
-            if (test_seconds_elapsed_for_frame > target_seconds_per_frame)  {
-                // @todo missed sleep here
-            }
-            
-            while (seconds_elapsed_for_frame < target_seconds_per_frame) {
-                seconds_elapsed_for_frame = win32_get_seconds_elapsed(last_counter, win32_get_wall_clock());
-            }
-        }
-        else {
-            // @todo missed frame rate!
-        }
-        
-        LARGE_INTEGER end_counter = win32_get_wall_clock();
-        f64 ms_per_frame = 1000.0f * win32_get_seconds_elapsed(last_counter, end_counter);
-        last_counter = end_counter;
-        
-        Game_Input *temp_input = new_input;
-        new_input = old_input;
-        old_input = temp_input;
+        wait_for_frame_end(&frame_scheduler);
+        Frame_Stats frame_stats = get_frame_stats(&frame_scheduler);
         
         u64 end_cycle_count = __rdtsc();
         u64 cycles_elapsed = end_cycle_count - last_cycle_count;
         last_cycle_count = end_cycle_count;
         
-        f64 fps = 0; // @note not a relevant measurement (f64)global_performance_count_frequency / (f64)counter_elapsed;
-        f64 mcpf = (f64)cycles_elapsed / (1000.0f * 1000.0f);
-        
-        char fps_buffer[256];
-        _snprintf_s(fps_buffer, sizeof(fps_buffer), "%.02fms/work, %.02fms/f, %.02ffps, %.02fmc/f\n", seconds_elapsed_for_work*1000, ms_per_frame, fps, mcpf);
-        OutputDebugStringA(fps_buffer);
+        record_frame_time(&global_frame_log, (f32)(frame_stats.last_work_seconds * 1000.0),
+                          (f32)(frame_stats.last_frame_seconds * 1000.0), (f32)(latency_seconds * 1000.0), cycles_elapsed);
+#if TETRIS_PROFILE
+        debug_end_frame();
+#endif
+        if (global_write_frame_log) {
+            win32_write_frame_log();
+            global_write_frame_log = false;
+        }
     }
     
+    win32_stop_input_thread();
+    win32_write_frame_log();
+    end_replay_recording(&replay_recorder, &game_state);
+    if (replay_file)  fclose(replay_file);
+    
     return 0;
 }
\ No newline at end of file